@@ -0,0 +1,36 @@
+#include "AudioDecoder.h"
+
+#include <cstring>
+#include <cwctype>
+#include <string>
+
+AudioDecoder::Format AudioDecoder::detect(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path) {
+    if (data != nullptr) {
+        if (size >= 4 && std::memcmp(data, "fLaC", 4) == 0)
+            return Format::Flac;
+
+        if (size >= 12 && std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WAVE", 4) == 0)
+            return Format::Wav;
+    }
+
+    return formatFromExtension(path);
+}
+
+AudioDecoder::Format AudioDecoder::formatFromExtension(const std::filesystem::path& path) {
+    std::wstring ext = path.extension().wstring();
+    for (auto& c : ext)
+        c = static_cast<wchar_t>(std::towlower(c));
+
+    if (ext == L".mp3")
+        return Format::Mp3;
+    if (ext == L".wav")
+        return Format::Wav;
+    if (ext == L".flac")
+        return Format::Flac;
+
+    return Format::Unknown;
+}
+
+bool AudioDecoder::isSupportedExtension(const std::filesystem::path& path) {
+    return formatFromExtension(path) != Format::Unknown;
+}
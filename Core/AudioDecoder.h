@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#include "SampleType.h"
+
+/*
+ * Streaming PCM source the analysis path reads from, whatever the container.
+ * Every implementation hands out mono (or mid/side) samples in [-1, 1) in caller-sized chunks,
+ * so the frame assembler and the STFT never see the file format.
+ */
+class AudioDecoder {
+public:
+    enum class Format { Unknown, Mp3, Wav, Flac };
+
+    virtual ~AudioDecoder() = default;
+
+    // The caller keeps data alive until close().
+    virtual bool open(const std::uint8_t* data, std::size_t size) = 0;
+    virtual std::size_t readMono(Sample* out, std::size_t maxFrames) = 0;
+    // mid is exactly what readMono returns; side is (L - R) / 2 of the first two channels, 0 for mono.
+    virtual std::size_t readMidSide(Sample* mid, Sample* side, std::size_t maxFrames) = 0;
+    virtual bool seek(std::uint64_t frame) = 0;
+    virtual void close() = 0;
+
+    virtual bool failed() const = 0;
+    virtual int getSampleRate() const = 0;
+    virtual int getChannels() const = 0;
+    // 0 when the stream does not say.
+    virtual std::uint64_t getTotalFrames() const = 0;
+
+    // Magic bytes win over the extension; an ID3 tag in front of the audio says nothing, so the extension decides then.
+    static Format detect(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path);
+    static Format formatFromExtension(const std::filesystem::path& path);
+    static bool isSupportedExtension(const std::filesystem::path& path);
+};
@@ -1,22 +1,29 @@
 #include "FeatureExtractor.h"
 #include <algorithm>
+#include <cmath>
 
-static constexpr double EPS = 1e-12;
+#include "MelFilterbank.h"
+#include "PitchClassMap.h"
+#include "SpectrumKernels.h"
+
+static constexpr Sample EPS = static_cast<Sample>(1e-12);
 static constexpr double HF_SPLIT_HZ = 2000.0;
+// Bins whose magnitudes are taken at once; small enough to stay on the stack and in L1.
+static constexpr int MAGNITUDE_CHUNK = 256;
 
 FeatureExtractor::FeatureExtractor(int sampleRate)
     : sampleRate(sampleRate) {
 }
 
-FrameFeatures FeatureExtractor::extract(const std::vector<double>& magnitudes) const {
+FrameFeatures FeatureExtractor::extract(std::span<const Sample> power) const {
     FrameFeatures features{};
-    const int bins = static_cast<int>(magnitudes.size());
+    const int bins = static_cast<int>(power.size());
 
     if (bins < 2 || sampleRate <= 0)
         return features;
 
-    const double nyquist = sampleRate * 0.5;
-    const double binHz = nyquist / (bins - 1);
+    const Sample nyquist = sampleRate * static_cast<Sample>(0.5);
+    const Sample binHz = nyquist / (bins - 1);
     if (binHz <= 0.0)
         return features;
 
@@ -27,42 +34,50 @@ FrameFeatures FeatureExtractor::extract(const std::vector<double>& magnitudes) c
     if (hfSplitBin > bins) 
         hfSplitBin = bins;
 
-    double energySum = 0.0, weightedFreqSum = 0.0, magSum = 0.0, logSum = 0.0;
-    double peak = 0.0, lowEnergy = 0.0, highEnergy = 0.0;
+    Sample energySum = 0, weightedFreqSum = 0, magSum = 0, logSum = 0;
+    Sample peakPower = 0, lowEnergy = 0, highEnergy = 0;
 
-    for (int i = 0; i < bins; ++i) {
-        const double mag = magnitudes[i];
-        const double mag2 = mag * mag;
+    // Energy, HF ratio, RMS and rolloff work on power directly; only centroid and flatness need magnitudes.
+    Sample magnitudes[MAGNITUDE_CHUNK];
+    for (int base = 0; base < bins; base += MAGNITUDE_CHUNK) {
+        const int count = std::min(MAGNITUDE_CHUNK, bins - base);
+        SpectrumKernels::magnitudes(power.data() + base, static_cast<std::size_t>(count), magnitudes);
+
+        for (int k = 0; k < count; ++k) {
+            const int i = base + k;
+            const Sample pow = power[i];
+            const Sample mag = magnitudes[k];
 
-        energySum += mag2;
-        magSum += mag;
-        logSum += std::log(mag + EPS);
-        peak = std::max(peak, mag);
+            energySum += pow;
+            magSum += mag;
+            logSum += std::log(mag + EPS);
+            peakPower = std::max(peakPower, pow);
 
-        weightedFreqSum += (i * binHz) * mag;
+            weightedFreqSum += (i * binHz) * mag;
 
-        if (i < hfSplitBin) 
-            lowEnergy += mag2;
-        else
-        	highEnergy += mag2;
+            if (i < hfSplitBin)
+                lowEnergy += pow;
+            else
+                highEnergy += pow;
+        }
     }
 
     features.spectralRms = std::sqrt(energySum / bins);
-    features.peak = peak;
+    features.peak = std::sqrt(peakPower);
     features.spectralCentroid = weightedFreqSum / (magSum + EPS);
 
-    const double geoMean = std::exp(logSum / bins);
-    const double arithMean = magSum / bins;
+    const Sample geoMean = std::exp(logSum / bins);
+    const Sample arithMean = magSum / bins;
     features.spectralFlatness = geoMean / (arithMean + EPS);
 
     features.hfRatio = highEnergy / (lowEnergy + EPS);
 
-    const double targetEnergy = energySum * 0.85;
-    double cumulativeEnergy = 0.0;
+    const Sample targetEnergy = energySum * static_cast<Sample>(0.85);
+    Sample cumulativeEnergy = 0;
 
     features.spectralRolloff85 = (bins - 1) * binHz;
     for (int i = 0; i < bins; ++i) {
-        cumulativeEnergy += magnitudes[i] * magnitudes[i];
+        cumulativeEnergy += power[i];
         if (cumulativeEnergy >= targetEnergy) {
             features.spectralRolloff85 = i * binHz;
             break;
@@ -70,4 +85,49 @@ FrameFeatures FeatureExtractor::extract(const std::vector<double>& magnitudes) c
     }
 
     return features;
-}
\ No newline at end of file
+}
+
+void FeatureExtractor::extractMfcc(std::span<const Sample> power, FrameMfcc& out) const {
+    if (power.size() < 2 || sampleRate <= 0) {
+        out = {};
+        return;
+    }
+
+    MelFilterbank::get(sampleRate, static_cast<int>(power.size())).mfcc(power.data(), out.data());
+}
+
+void FeatureExtractor::extractChroma(std::span<const Sample> power, FrameChroma& out) const {
+    if (power.size() < 2 || sampleRate <= 0) {
+        out = {};
+        return;
+    }
+
+    PitchClassMap::get(sampleRate, static_cast<int>(power.size())).chroma(power.data(), out.data());
+}
+
+void FeatureExtractor::extractStereo(std::span<const Sample> midPower, std::span<const Sample> sidePower, FrameFeatures& features) const {
+    const std::size_t bins = std::min(midPower.size(), sidePower.size());
+
+    Sample midEnergy = 0, sideEnergy = 0, weightedWidth = 0;
+
+    // The width weight is a ratio of magnitudes; the energies are power as is.
+    Sample mid[MAGNITUDE_CHUNK], side[MAGNITUDE_CHUNK];
+    for (std::size_t base = 0; base < bins; base += MAGNITUDE_CHUNK) {
+        const std::size_t count = std::min<std::size_t>(MAGNITUDE_CHUNK, bins - base);
+        SpectrumKernels::magnitudes(midPower.data() + base, count, mid);
+        SpectrumKernels::magnitudes(sidePower.data() + base, count, side);
+
+        for (std::size_t k = 0; k < count; ++k) {
+            const Sample m2 = midPower[base + k];
+            const Sample s2 = sidePower[base + k];
+
+            midEnergy += m2;
+            sideEnergy += s2;
+            weightedWidth += (m2 + s2) * (side[k] / (mid[k] + side[k] + EPS));
+        }
+    }
+
+    const Sample totalEnergy = midEnergy + sideEnergy;
+    features.sideEnergyRatio = sideEnergy / (totalEnergy + EPS);
+    features.stereoWidth = weightedWidth / (totalEnergy + EPS);
+}
@@ -1,12 +1,21 @@
 #pragma once
 
-#include <vector>
+#include <span>
 #include "../Model/TrackData.h"
+#include "SampleType.h"
 
 class FeatureExtractor {
 public:
     FeatureExtractor(int sampleRate);
-    FrameFeatures extract(const std::vector<double>& magnitudes) const;
+    // power is one frame's power spectrum (re^2 + im^2 per bin), as StftFrame carries it.
+    FrameFeatures extract(std::span<const Sample> power) const;
+    // Only the main resolution's MFCCs are stored. They come from the same spectrum as extract(), so they cost no
+    // transform of their own.
+    void extractMfcc(std::span<const Sample> power, FrameMfcc& out) const;
+    // Needs the frames of a LONG_WINDOW_SIZE STFT to reach below ~360 Hz, see TrackContext::tonal.
+    void extractChroma(std::span<const Sample> power, FrameChroma& out) const;
+    // Fills stereoWidth and sideEnergyRatio from the mid and side power spectra of the same frame.
+    void extractStereo(std::span<const Sample> midPower, std::span<const Sample> sidePower, FrameFeatures& features) const;
 
 private:
     int sampleRate;
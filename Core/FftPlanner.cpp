@@ -0,0 +1,72 @@
+#include "FftPlanner.h"
+
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+    std::mutex plannerMutex;
+    unsigned plannerFlags = FFTW_MEASURE;
+    std::map<std::pair<int, int>, FftwPlan> forwardPlans; // (size, frames)
+
+    // Single and double precision keep separate wisdom; each FFTW library rejects the other's.
+    std::string wisdomFile(const std::filesystem::path& path) {
+#ifdef SPECTRAL_AUDIT_FLOAT32
+        return path.string() + ".f32";
+#else
+        return path.string();
+#endif
+    }
+}
+
+void FftPlanner::setPlannerFlags(unsigned flags) {
+    std::lock_guard<std::mutex> lk(plannerMutex);
+    plannerFlags = flags;
+}
+
+bool FftPlanner::loadWisdom(const std::filesystem::path& path) {
+    std::lock_guard<std::mutex> lk(plannerMutex);
+    return FFTW(import_wisdom_from_filename)(wisdomFile(path).c_str()) != 0;
+}
+
+bool FftPlanner::saveWisdom(const std::filesystem::path& path) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    std::lock_guard<std::mutex> lk(plannerMutex);
+    return FFTW(export_wisdom_to_filename)(wisdomFile(path).c_str()) != 0;
+}
+
+FftwPlan FftPlanner::realForward(int size) {
+    return realForwardBatch(size, 1);
+}
+
+FftwPlan FftPlanner::realForwardBatch(int size, int frames) {
+    std::lock_guard<std::mutex> lk(plannerMutex);
+
+    const auto it = forwardPlans.find({ size, frames });
+    if (it != forwardPlans.end())
+        return it->second;
+
+    const int bins = size / 2 + 1;
+
+    // Measuring overwrites the arrays, so it plans on scratch ones; their only lasting property is the alignment.
+    Sample* in = static_cast<Sample*>(FFTW(malloc)(sizeof(Sample) * size * frames));
+    FftwComplex* out = static_cast<FftwComplex*>(FFTW(malloc)(sizeof(FftwComplex) * bins * frames));
+    FftwPlan plan = nullptr;
+    if (in && out) {
+        plan = frames == 1
+            ? FFTW(plan_dft_r2c_1d)(size, in, out, plannerFlags)
+            : FFTW(plan_many_dft_r2c)(1, &size, frames, in, nullptr, 1, size, out, nullptr, 1, bins, plannerFlags);
+    }
+    FFTW(free)(in);
+    FFTW(free)(out);
+
+    if (!plan)
+        throw std::runtime_error("FFTW plan creation failed");
+
+    forwardPlans.emplace(std::make_pair(size, frames), plan);
+    return plan;
+}
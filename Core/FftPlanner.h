@@ -0,0 +1,27 @@
+#pragma once
+
+#include <filesystem>
+
+#include "SampleType.h"
+
+/*
+ * Process-wide FFTW plans, one per transform size and batch size, created once and shared read-only by every StftProcessor through
+ * the new-array execute functions; those are thread-safe, the planner is not, so all planning goes through here.
+ * Plans are measured (FFTW_MEASURE by default), and the wisdom is kept in a file so the measuring is paid once per
+ * machine rather than once per run.
+ */
+class FftPlanner {
+public:
+    // Call before the first plan; FFTW_PATIENT trades a longer first run for slightly faster plans.
+    static void setPlannerFlags(unsigned flags);
+
+    // False when the file is missing or was written by another FFTW build; planning then starts from scratch.
+    static bool loadWisdom(const std::filesystem::path& path);
+    static bool saveWisdom(const std::filesystem::path& path);
+
+    // Real-to-complex transform of `size` samples. The arrays it is executed on must come from FFTW(malloc), so
+    // their alignment matches the arrays it was planned with. Lives until the process exits.
+    static FftwPlan realForward(int size);
+    // `frames` such transforms in one call: inputs back to back `size` samples apart, outputs size / 2 + 1 bins apart.
+    static FftwPlan realForwardBatch(int size, int frames);
+};
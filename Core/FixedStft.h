@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <type_traits>
+
+#include "SampleType.h"
+#include "WindowFunction.h"
+#include "../Utilities/CpuFeatures.h"
+
+#ifdef SPECTRAL_AUDIT_X86
+#include <immintrin.h>
+#endif
+
+/*
+ * Windowing of one frame: out = frame * window, plus the sum of squares and the peak of the raw samples.
+ * The reductions keep eight partials (lane i % 8) combined in a fixed order, in scalar code and in registers alike,
+ * so every kernel returns the same bits. Count is a plain size or a std::integral_constant; the latter is how
+ * FixedStft gets loops with constant trip counts.
+ */
+namespace WindowKernels {
+    constexpr std::size_t LANES = 8;
+
+    // What StftProcessor calls per frame; fixed kernels ignore count and window in favour of their own.
+    using Kernel = void (*)(std::size_t count, const Sample* frame, const Sample* window, Sample* out, Sample& sumSquares, Sample& peak);
+
+    // Samples from i on go into the lane partials, which are then combined.
+    inline void finish(std::size_t i, std::size_t n, const Sample* frame, const Sample* window, Sample* out,
+        Sample (&sums)[LANES], Sample (&peaks)[LANES], Sample& sumSquares, Sample& peak) {
+        for (; i < n; ++i) {
+            const Sample s = frame[i];
+            const Sample a = s < 0 ? -s : s;
+            sums[i % LANES] += s * s;
+            peaks[i % LANES] = a > peaks[i % LANES] ? a : peaks[i % LANES];
+            out[i] = s * window[i];
+        }
+
+        Sample sum = 0, top = 0;
+        for (std::size_t l = 0; l < LANES; ++l) {
+            sum += sums[l];
+            top = peaks[l] > top ? peaks[l] : top;
+        }
+        sumSquares = sum;
+        peak = top;
+    }
+
+    template <typename Count>
+    inline void applyScalar(Count count, const Sample* frame, const Sample* window, Sample* out, Sample& sumSquares, Sample& peak) {
+        Sample sums[LANES] = {};
+        Sample peaks[LANES] = {};
+        finish(0, count, frame, window, out, sums, peaks, sumSquares, peak);
+    }
+
+#ifdef SPECTRAL_AUDIT_X86
+
+    template <typename Count>
+    SIMD_TARGET("sse2")
+    inline void applySse2(Count count, const Sample* frame, const Sample* window, Sample* out, Sample& sumSquares, Sample& peak) {
+        const std::size_t n = count;
+        const std::size_t body = n / LANES * LANES;
+        Sample sums[LANES], peaks[LANES];
+
+#ifdef SPECTRAL_AUDIT_FLOAT32
+        const __m128 magnitude = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+        __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps(), p0 = _mm_setzero_ps(), p1 = _mm_setzero_ps();
+        for (std::size_t i = 0; i < body; i += LANES) {
+            const __m128 x0 = _mm_loadu_ps(frame + i);
+            const __m128 x1 = _mm_loadu_ps(frame + i + 4);
+            s0 = _mm_add_ps(s0, _mm_mul_ps(x0, x0));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(x1, x1));
+            p0 = _mm_max_ps(_mm_and_ps(x0, magnitude), p0);
+            p1 = _mm_max_ps(_mm_and_ps(x1, magnitude), p1);
+            _mm_storeu_ps(out + i, _mm_mul_ps(x0, _mm_loadu_ps(window + i)));
+            _mm_storeu_ps(out + i + 4, _mm_mul_ps(x1, _mm_loadu_ps(window + i + 4)));
+        }
+        _mm_storeu_ps(sums, s0);
+        _mm_storeu_ps(sums + 4, s1);
+        _mm_storeu_ps(peaks, p0);
+        _mm_storeu_ps(peaks + 4, p1);
+#else
+        const __m128d magnitude = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFF));
+        __m128d s[4], p[4];
+        for (int r = 0; r < 4; ++r) {
+            s[r] = _mm_setzero_pd();
+            p[r] = _mm_setzero_pd();
+        }
+        for (std::size_t i = 0; i < body; i += LANES) {
+            for (int r = 0; r < 4; ++r) {
+                const __m128d x = _mm_loadu_pd(frame + i + 2 * r);
+                s[r] = _mm_add_pd(s[r], _mm_mul_pd(x, x));
+                p[r] = _mm_max_pd(_mm_and_pd(x, magnitude), p[r]);
+                _mm_storeu_pd(out + i + 2 * r, _mm_mul_pd(x, _mm_loadu_pd(window + i + 2 * r)));
+            }
+        }
+        for (int r = 0; r < 4; ++r) {
+            _mm_storeu_pd(sums + 2 * r, s[r]);
+            _mm_storeu_pd(peaks + 2 * r, p[r]);
+        }
+#endif
+        finish(body, n, frame, window, out, sums, peaks, sumSquares, peak);
+    }
+
+    template <typename Count>
+    SIMD_TARGET("avx2")
+    inline void applyAvx2(Count count, const Sample* frame, const Sample* window, Sample* out, Sample& sumSquares, Sample& peak) {
+        const std::size_t n = count;
+        const std::size_t body = n / LANES * LANES;
+        Sample sums[LANES], peaks[LANES];
+
+#ifdef SPECTRAL_AUDIT_FLOAT32
+        const __m256 magnitude = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+        __m256 s = _mm256_setzero_ps(), p = _mm256_setzero_ps();
+        for (std::size_t i = 0; i < body; i += LANES) {
+            const __m256 x = _mm256_loadu_ps(frame + i);
+            s = _mm256_add_ps(s, _mm256_mul_ps(x, x));
+            p = _mm256_max_ps(_mm256_and_ps(x, magnitude), p);
+            _mm256_storeu_ps(out + i, _mm256_mul_ps(x, _mm256_loadu_ps(window + i)));
+        }
+        _mm256_storeu_ps(sums, s);
+        _mm256_storeu_ps(peaks, p);
+#else
+        const __m256d magnitude = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFF));
+        __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd(), p0 = _mm256_setzero_pd(), p1 = _mm256_setzero_pd();
+        for (std::size_t i = 0; i < body; i += LANES) {
+            const __m256d x0 = _mm256_loadu_pd(frame + i);
+            const __m256d x1 = _mm256_loadu_pd(frame + i + 4);
+            s0 = _mm256_add_pd(s0, _mm256_mul_pd(x0, x0));
+            s1 = _mm256_add_pd(s1, _mm256_mul_pd(x1, x1));
+            p0 = _mm256_max_pd(_mm256_and_pd(x0, magnitude), p0);
+            p1 = _mm256_max_pd(_mm256_and_pd(x1, magnitude), p1);
+            _mm256_storeu_pd(out + i, _mm256_mul_pd(x0, _mm256_loadu_pd(window + i)));
+            _mm256_storeu_pd(out + i + 4, _mm256_mul_pd(x1, _mm256_loadu_pd(window + i + 4)));
+        }
+        _mm256_storeu_pd(sums, s0);
+        _mm256_storeu_pd(sums + 4, s1);
+        _mm256_storeu_pd(peaks, p0);
+        _mm256_storeu_pd(peaks + 4, p1);
+#endif
+        finish(body, n, frame, window, out, sums, peaks, sumSquares, peak);
+    }
+
+#endif
+
+    // Picks the widest of applyScalar/applySse2/applyAvx2 the CPU runs; Impl supplies count and window.
+    template <typename Impl>
+    Kernel select() {
+#ifdef SPECTRAL_AUDIT_X86
+        const CpuFeatures& cpu = CpuFeatures::get();
+        if (cpu.avx2)
+            return &Impl::avx2;
+        if (cpu.sse2)
+            return &Impl::sse2;
+#endif
+        return &Impl::scalar;
+    }
+
+    // Any window length, with the window read from the caller's buffer.
+    struct Generic {
+        static void scalar(std::size_t count, const Sample* frame, const Sample* window, Sample* out, Sample& sumSquares, Sample& peak) {
+            applyScalar(count, frame, window, out, sumSquares, peak);
+        }
+#ifdef SPECTRAL_AUDIT_X86
+        static void sse2(std::size_t count, const Sample* frame, const Sample* window, Sample* out, Sample& sumSquares, Sample& peak) {
+            applySse2(count, frame, window, out, sumSquares, peak);
+        }
+        static void avx2(std::size_t count, const Sample* frame, const Sample* window, Sample* out, Sample& sumSquares, Sample& peak) {
+            applyAvx2(count, frame, window, out, sumSquares, peak);
+        }
+#endif
+    };
+}
+
+/*
+ * The windowing kernel of one window length and function fixed at compile time, with the window as a constexpr
+ * table. StftProcessor dispatches the window lengths the program runs to these kernels; they return the generic
+ * kernel's results bit for bit, with every loop bound a constant.
+ */
+template <int N, WindowFunction Fn>
+struct FixedStft {
+    static_assert(N >= 2, "Invalid window size");
+
+    alignas(64) static constexpr std::array<Sample, N> table = WindowMath::table<N, Fn>();
+
+    static void scalar(std::size_t, const Sample* frame, const Sample*, Sample* out, Sample& sumSquares, Sample& peak) {
+        WindowKernels::applyScalar(std::integral_constant<std::size_t, N>{}, frame, table.data(), out, sumSquares, peak);
+    }
+#ifdef SPECTRAL_AUDIT_X86
+    static void sse2(std::size_t, const Sample* frame, const Sample*, Sample* out, Sample& sumSquares, Sample& peak) {
+        WindowKernels::applySse2(std::integral_constant<std::size_t, N>{}, frame, table.data(), out, sumSquares, peak);
+    }
+    static void avx2(std::size_t, const Sample* frame, const Sample*, Sample* out, Sample& sumSquares, Sample& peak) {
+        WindowKernels::applyAvx2(std::integral_constant<std::size_t, N>{}, frame, table.data(), out, sumSquares, peak);
+    }
+#endif
+
+    static WindowKernels::Kernel kernel() {
+        return WindowKernels::select<FixedStft>();
+    }
+};
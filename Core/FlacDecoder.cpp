@@ -0,0 +1,268 @@
+#include "FlacDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include <FLAC/stream_decoder.h>
+
+
+namespace {
+    // What the libFLAC callbacks see; they cannot name the private FlacDecoder::Stream.
+    struct FlacState {
+        const std::uint8_t* data = nullptr;
+        std::size_t size = 0;
+        std::size_t offset = 0;
+
+        // The current FLAC block, channel after channel; capacity is kept between blocks and tracks.
+        std::vector<FLAC__int32> block;
+        std::size_t blockFrames = 0;
+        std::size_t blockPosition = 0;
+
+        int sampleRate = 0;
+        int channels = 0;
+        int bitsPerSample = 0;
+        std::uint64_t totalFrames = 0;
+        bool opened = false;
+        bool error = false;
+    };
+}
+
+struct FlacDecoder::Stream : FlacState {
+    FLAC__StreamDecoder* decoder = nullptr;
+};
+
+static FLAC__StreamDecoderReadStatus readCallback(const FLAC__StreamDecoder*, FLAC__byte buffer[], size_t* bytes, void* clientData) {
+    auto& s = *static_cast<FlacState*>(clientData);
+
+    const std::size_t n = std::min(*bytes, s.size - s.offset);
+    if (n == 0) {
+        *bytes = 0;
+        return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+    }
+
+    std::memcpy(buffer, s.data + s.offset, n);
+    s.offset += n;
+    *bytes = n;
+    return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+}
+
+static FLAC__StreamDecoderSeekStatus seekCallback(const FLAC__StreamDecoder*, FLAC__uint64 absoluteByteOffset, void* clientData) {
+    auto& s = *static_cast<FlacState*>(clientData);
+    if (absoluteByteOffset > s.size)
+        return FLAC__STREAM_DECODER_SEEK_STATUS_ERROR;
+
+    s.offset = static_cast<std::size_t>(absoluteByteOffset);
+    return FLAC__STREAM_DECODER_SEEK_STATUS_OK;
+}
+
+static FLAC__StreamDecoderTellStatus tellCallback(const FLAC__StreamDecoder*, FLAC__uint64* absoluteByteOffset, void* clientData) {
+    *absoluteByteOffset = static_cast<const FlacState*>(clientData)->offset;
+    return FLAC__STREAM_DECODER_TELL_STATUS_OK;
+}
+
+static FLAC__StreamDecoderLengthStatus lengthCallback(const FLAC__StreamDecoder*, FLAC__uint64* streamLength, void* clientData) {
+    *streamLength = static_cast<const FlacState*>(clientData)->size;
+    return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
+}
+
+static FLAC__bool eofCallback(const FLAC__StreamDecoder*, void* clientData) {
+    const auto& s = *static_cast<const FlacState*>(clientData);
+    return s.offset >= s.size;
+}
+
+static FLAC__StreamDecoderWriteStatus writeCallback(const FLAC__StreamDecoder*, const FLAC__Frame* frame, const FLAC__int32* const buffer[], void* clientData) {
+    auto& s = *static_cast<FlacState*>(clientData);
+
+    const std::size_t frames = frame->header.blocksize;
+    const std::size_t channels = frame->header.channels;
+    if (static_cast<int>(channels) != s.channels)
+        return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+
+    s.block.resize(frames * channels);
+    for (std::size_t c = 0; c < channels; ++c)
+        std::memcpy(s.block.data() + c * frames, buffer[c], frames * sizeof(FLAC__int32));
+
+    s.blockFrames = frames;
+    s.blockPosition = 0;
+    return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static void metadataCallback(const FLAC__StreamDecoder*, const FLAC__StreamMetadata* metadata, void* clientData) {
+    if (metadata->type != FLAC__METADATA_TYPE_STREAMINFO)
+        return;
+
+    auto& s = *static_cast<FlacState*>(clientData);
+    const auto& info = metadata->data.stream_info;
+
+    s.sampleRate = static_cast<int>(info.sample_rate);
+    s.channels = static_cast<int>(info.channels);
+    s.bitsPerSample = static_cast<int>(info.bits_per_sample);
+    s.totalFrames = info.total_samples;
+}
+
+// Lost sync and bad CRCs are reported per frame and skipped; libFLAC carries on with the next frame.
+static void errorCallback(const FLAC__StreamDecoder*, FLAC__StreamDecoderErrorStatus, void*) {
+}
+
+FlacDecoder::FlacDecoder()
+    : stream(std::make_unique<Stream>()) {
+    stream->decoder = FLAC__stream_decoder_new();
+}
+
+FlacDecoder::~FlacDecoder() {
+    close();
+
+    if (stream->decoder)
+        FLAC__stream_decoder_delete(stream->decoder);
+}
+
+// The caller keeps data alive until close().
+bool FlacDecoder::open(const std::uint8_t* data, std::size_t size) {
+    close();
+
+    stream->data = data;
+    stream->size = size;
+    return finishOpen();
+}
+
+bool FlacDecoder::finishOpen() {
+    Stream& s = *stream;
+    if (!s.decoder)
+        return false;
+
+    s.offset = 0;
+    s.blockFrames = 0;
+    s.blockPosition = 0;
+    s.sampleRate = 0;
+    s.channels = 0;
+    s.bitsPerSample = 0;
+    s.totalFrames = 0;
+    s.error = false;
+
+    const FLAC__StreamDecoderInitStatus status = FLAC__stream_decoder_init_stream(s.decoder,
+        readCallback, seekCallback, tellCallback, lengthCallback, eofCallback,
+        writeCallback, metadataCallback, errorCallback, &s);
+
+    if (status != FLAC__STREAM_DECODER_INIT_STATUS_OK)
+        return false;
+
+    s.opened = true;
+
+    if (!FLAC__stream_decoder_process_until_end_of_metadata(s.decoder)
+        || s.sampleRate <= 0 || s.channels <= 0 || s.bitsPerSample <= 0 || s.bitsPerSample > 32) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+std::size_t FlacDecoder::readMono(Sample* out, std::size_t maxFrames) {
+    return read(out, nullptr, maxFrames);
+}
+
+std::size_t FlacDecoder::readMidSide(Sample* mid, Sample* side, std::size_t maxFrames) {
+    return read(mid, side, maxFrames);
+}
+
+// mid is the mean of all channels, side (L - R) / 2, matching the other decoders.
+std::size_t FlacDecoder::read(Sample* mid, Sample* side, std::size_t maxFrames) {
+    Stream& s = *stream;
+    if (!s.opened || s.error)
+        return 0;
+
+    const double scale = 1.0 / static_cast<double>(std::uint64_t{ 1 } << (s.bitsPerSample - 1));
+    const double midScale = scale / s.channels;
+    const double sideScale = scale * 0.5;
+
+    std::size_t done = 0;
+    while (done < maxFrames) {
+        if (s.blockPosition == s.blockFrames) {
+            s.blockFrames = 0;
+            s.blockPosition = 0;
+
+            if (!FLAC__stream_decoder_process_single(s.decoder)) {
+                s.error = true;
+                break;
+            }
+
+            if (FLAC__stream_decoder_get_state(s.decoder) == FLAC__STREAM_DECODER_END_OF_STREAM && s.blockFrames == 0)
+                break;
+
+            continue;
+        }
+
+        const std::size_t n = std::min(s.blockFrames - s.blockPosition, maxFrames - done);
+        const FLAC__int32* first = s.block.data() + s.blockPosition;
+
+        for (std::size_t i = 0; i < n; ++i) {
+            std::int64_t sum = 0;
+            for (int c = 0; c < s.channels; ++c)
+                sum += first[c * s.blockFrames + i];
+            mid[done + i] = static_cast<Sample>(sum * midScale);
+        }
+
+        if (side) {
+            if (s.channels > 1) {
+                const FLAC__int32* second = first + s.blockFrames;
+                for (std::size_t i = 0; i < n; ++i)
+                    side[done + i] = static_cast<Sample>((static_cast<std::int64_t>(first[i]) - second[i]) * sideScale);
+            }
+            else {
+                std::fill(side + done, side + done + n, Sample{ 0 });
+            }
+        }
+
+        s.blockPosition += n;
+        done += n;
+    }
+
+    return done;
+}
+
+// libFLAC delivers the block holding the target sample through the write callback, already trimmed to start there.
+bool FlacDecoder::seek(std::uint64_t frame) {
+    Stream& s = *stream;
+    if (!s.opened)
+        return false;
+
+    s.blockFrames = 0;
+    s.blockPosition = 0;
+
+    if (FLAC__stream_decoder_seek_absolute(s.decoder, frame))
+        return true;
+
+    if (FLAC__stream_decoder_get_state(s.decoder) == FLAC__STREAM_DECODER_SEEK_ERROR)
+        FLAC__stream_decoder_flush(s.decoder);
+
+    s.blockFrames = 0;
+    return false;
+}
+
+void FlacDecoder::close() {
+    Stream& s = *stream;
+    if (!s.opened)
+        return;
+
+    FLAC__stream_decoder_finish(s.decoder);
+    s.data = nullptr;
+    s.size = 0;
+    s.opened = false;
+}
+
+bool FlacDecoder::failed() const {
+    return stream->error;
+}
+
+int FlacDecoder::getSampleRate() const {
+    return stream->sampleRate;
+}
+
+int FlacDecoder::getChannels() const {
+    return stream->channels;
+}
+
+std::uint64_t FlacDecoder::getTotalFrames() const {
+    return stream->totalFrames;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "AudioDecoder.h"
+#include "SampleType.h"
+
+/*
+ * Streaming FLAC through libFLAC's stream decoder, fed from memory. Holds one decoded FLAC block at a time
+ * and hands it out in whatever chunk size the caller asks for. The libFLAC decoder is created once and
+ * re-initialized per track.
+ */
+class FlacDecoder : public AudioDecoder {
+public:
+    FlacDecoder();
+    ~FlacDecoder() override;
+
+    FlacDecoder(const FlacDecoder&) = delete;
+    FlacDecoder& operator=(const FlacDecoder&) = delete;
+
+    bool open(const std::uint8_t* data, std::size_t size) override;
+    std::size_t readMono(Sample* out, std::size_t maxFrames) override;
+    std::size_t readMidSide(Sample* mid, Sample* side, std::size_t maxFrames) override;
+    bool seek(std::uint64_t frame) override;
+    void close() override;
+
+    bool failed() const override;
+    int getSampleRate() const override;
+    int getChannels() const override;
+    std::uint64_t getTotalFrames() const override;
+
+private:
+    bool finishOpen();
+    std::size_t read(Sample* mid, Sample* side, std::size_t maxFrames);
+
+    struct Stream;
+    std::unique_ptr<Stream> stream;
+};
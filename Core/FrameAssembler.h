@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "SampleType.h"
+
+/*
+ * Turns an arbitrarily chunked PCM stream into overlapping analysis frames.
+ * Frame k always starts at sample k * hopSize, exactly like StftProcessor::computeMagnitudes,
+ * but only windowSize + a few hops of samples are ever held regardless of track length.
+ */
+class FrameAssembler {
+public:
+    FrameAssembler(int windowSize, int hopSize)
+        : windowSize(static_cast<std::size_t>(windowSize)),
+        hopSize(static_cast<std::size_t>(hopSize)) {
+        if (windowSize < 1 || hopSize <= 0)
+            throw std::invalid_argument("Invalid windowSize or hopSize");
+
+        buffer.resize(this->windowSize + std::max(this->windowSize, this->hopSize));
+    }
+
+    void reset() {
+        start = 0;
+        end = 0;
+        pendingSkip = 0;
+    }
+
+    // Calls onFrame(const Sample* frame) for every frame completed by this chunk.
+    template <typename OnFrame>
+    void push(const Sample* samples, std::size_t count, OnFrame&& onFrame) {
+        pushImpl(samples, nullptr, count, [&](const Sample* frame, const Sample*) {
+            onFrame(frame);
+            });
+    }
+
+    // Two channels (e.g. mid and side) framed in lockstep: onFrame(const Sample* first, const Sample* second).
+    template <typename OnFrame>
+    void pushPair(const Sample* first, const Sample* second, std::size_t count, OnFrame&& onFrame) {
+        if (pairBuffer.size() != buffer.size())
+            pairBuffer.resize(buffer.size());
+
+        pushImpl(first, second, count, onFrame);
+    }
+
+private:
+    template <typename OnFrame>
+    void pushImpl(const Sample* samples, const Sample* pairSamples, std::size_t count, OnFrame&& onFrame) {
+        while (count > 0) {
+            if (pendingSkip > 0) {
+                const std::size_t skip = std::min(pendingSkip, count);
+                pendingSkip -= skip;
+                samples += skip;
+                if (pairSamples)
+                    pairSamples += skip;
+                count -= skip;
+                continue;
+            }
+
+            if (end == buffer.size())
+                compact(pairSamples != nullptr);
+
+            const std::size_t take = std::min(count, buffer.size() - end);
+            std::memcpy(buffer.data() + end, samples, take * sizeof(Sample));
+            samples += take;
+            if (pairSamples) {
+                std::memcpy(pairBuffer.data() + end, pairSamples, take * sizeof(Sample));
+                pairSamples += take;
+            }
+            end += take;
+            count -= take;
+
+            while (end - start >= windowSize) {
+                onFrame(static_cast<const Sample*>(buffer.data() + start),
+                    pairSamples ? static_cast<const Sample*>(pairBuffer.data() + start) : nullptr);
+                start += hopSize;
+
+                if (start > end) {
+                    pendingSkip = start - end;
+                    start = end;
+                }
+            }
+        }
+    }
+
+    void compact(bool pair) {
+        const std::size_t remaining = end - start;
+        std::memmove(buffer.data(), buffer.data() + start, remaining * sizeof(Sample));
+        if (pair)
+            std::memmove(pairBuffer.data(), pairBuffer.data() + start, remaining * sizeof(Sample));
+        start = 0;
+        end = remaining;
+    }
+
+    std::size_t windowSize;
+    std::size_t hopSize;
+
+    std::vector<Sample> buffer;
+    std::vector<Sample> pairBuffer; // sized on the first pushPair()
+    std::size_t start = 0;
+    std::size_t end = 0;
+    std::size_t pendingSkip = 0;
+};
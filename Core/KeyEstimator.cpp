@@ -0,0 +1,57 @@
+#include "KeyEstimator.h"
+
+#include <cmath>
+
+static constexpr int PITCH_CLASSES = CONSTANTS::PITCH_CLASSES;
+
+// Krumhansl & Kessler (1982) probe-tone ratings, tonic first.
+static constexpr double MAJOR_PROFILE[PITCH_CLASSES] = { 6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88 };
+static constexpr double MINOR_PROFILE[PITCH_CLASSES] = { 6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17 };
+
+static constexpr const char* PITCH_CLASS_NAMES[PITCH_CLASSES] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+
+// Pearson correlation of chroma with the profile rotated so that its tonic falls on pitch class `tonic`.
+static double correlation(const double* chroma, const double (&profile)[PITCH_CLASSES], int tonic) {
+    double chromaMean = 0.0, profileMean = 0.0;
+    for (int pc = 0; pc < PITCH_CLASSES; ++pc) {
+        chromaMean += chroma[pc];
+        profileMean += profile[pc];
+    }
+    chromaMean /= PITCH_CLASSES;
+    profileMean /= PITCH_CLASSES;
+
+    double cross = 0.0, chromaVar = 0.0, profileVar = 0.0;
+    for (int pc = 0; pc < PITCH_CLASSES; ++pc) {
+        const double c = chroma[pc] - chromaMean;
+        const double p = profile[(pc - tonic + PITCH_CLASSES) % PITCH_CLASSES] - profileMean;
+        cross += c * p;
+        chromaVar += c * c;
+        profileVar += p * p;
+    }
+
+    return chromaVar > 0.0 ? cross / std::sqrt(chromaVar * profileVar) : 0.0;
+}
+
+KeyEstimate KeyEstimator::estimate(const double* chroma) {
+    KeyEstimate best{};
+
+    double spread = 0.0;
+    for (int pc = 1; pc < PITCH_CLASSES; ++pc)
+        spread += std::abs(chroma[pc] - chroma[0]);
+    if (spread == 0.0)
+        return best;
+
+    best.strength = -2.0; // below any correlation
+    for (int tonic = 0; tonic < PITCH_CLASSES; ++tonic) {
+        for (KeyMode mode : { KeyMode::Major, KeyMode::Minor }) {
+            const double r = correlation(chroma, mode == KeyMode::Major ? MAJOR_PROFILE : MINOR_PROFILE, tonic);
+            if (r > best.strength)
+                best = { tonic, mode, r };
+        }
+    }
+    return best;
+}
+
+const char* KeyEstimator::pitchClassName(int pitchClass) {
+    return pitchClass >= 0 && pitchClass < PITCH_CLASSES ? PITCH_CLASS_NAMES[pitchClass] : "";
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "../Model/TrackData.h"
+
+/*
+ * Krumhansl-Schmuckler key finding: the track chroma is correlated with the Krumhansl-Kessler major and minor
+ * profiles rotated to each of the 12 tonics, and the best of the 24 keys wins.
+ */
+class KeyEstimator {
+public:
+    // chroma holds PITCH_CLASSES values, 0 = C. Returns tonic -1 for an all-zero or flat chroma.
+    static KeyEstimate estimate(const double* chroma);
+
+    // "C", "C#", ... "B".
+    static const char* pitchClassName(int pitchClass);
+};
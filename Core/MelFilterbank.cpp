@@ -0,0 +1,189 @@
+#include "MelFilterbank.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "../Utilities/CpuFeatures.h"
+
+#ifdef SPECTRAL_AUDIT_X86
+#include <immintrin.h>
+#endif
+
+static constexpr std::size_t LANES = 8;
+// Floor under the band energies before the log, so silent bands give a finite coefficient.
+static constexpr double LOG_FLOOR = 1e-10;
+static constexpr double PI = 3.14159265358979323846;
+
+static double hzToMel(double hz) {
+    return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+static double melToHz(double mel) {
+    return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+// Products from i on go into the lane partials, which are then combined.
+static Sample finishDot(std::size_t i, std::size_t n, const Sample* a, const Sample* b, Sample (&sums)[LANES]) {
+    for (; i < n; ++i)
+        sums[i % LANES] += a[i] * b[i];
+
+    Sample sum = 0;
+    for (std::size_t l = 0; l < LANES; ++l)
+        sum += sums[l];
+    return sum;
+}
+
+static Sample dotScalar(const Sample* a, const Sample* b, std::size_t n) {
+    Sample sums[LANES] = {};
+    return finishDot(0, n, a, b, sums);
+}
+
+#ifdef SPECTRAL_AUDIT_X86
+
+SIMD_TARGET("sse2")
+static Sample dotSse2(const Sample* a, const Sample* b, std::size_t n) {
+    const std::size_t body = n / LANES * LANES;
+    Sample sums[LANES];
+
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+    for (std::size_t i = 0; i < body; i += LANES) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    _mm_storeu_ps(sums, s0);
+    _mm_storeu_ps(sums + 4, s1);
+#else
+    __m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd(), s2 = _mm_setzero_pd(), s3 = _mm_setzero_pd();
+    for (std::size_t i = 0; i < body; i += LANES) {
+        s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+        s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(a + i + 2), _mm_loadu_pd(b + i + 2)));
+        s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_loadu_pd(a + i + 4), _mm_loadu_pd(b + i + 4)));
+        s3 = _mm_add_pd(s3, _mm_mul_pd(_mm_loadu_pd(a + i + 6), _mm_loadu_pd(b + i + 6)));
+    }
+    _mm_storeu_pd(sums, s0);
+    _mm_storeu_pd(sums + 2, s1);
+    _mm_storeu_pd(sums + 4, s2);
+    _mm_storeu_pd(sums + 6, s3);
+#endif
+    return finishDot(body, n, a, b, sums);
+}
+
+// No FMA: a fused multiply-add rounds once where the scalar loop rounds twice.
+SIMD_TARGET("avx2")
+static Sample dotAvx2(const Sample* a, const Sample* b, std::size_t n) {
+    const std::size_t body = n / LANES * LANES;
+    Sample sums[LANES];
+
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    __m256 s = _mm256_setzero_ps();
+    for (std::size_t i = 0; i < body; i += LANES)
+        s = _mm256_add_ps(s, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    _mm256_storeu_ps(sums, s);
+#else
+    __m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+    for (std::size_t i = 0; i < body; i += LANES) {
+        s0 = _mm256_add_pd(s0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+    }
+    _mm256_storeu_pd(sums, s0);
+    _mm256_storeu_pd(sums + 4, s1);
+#endif
+    return finishDot(body, n, a, b, sums);
+}
+
+#endif
+
+namespace {
+    using DotKernel = Sample (*)(const Sample*, const Sample*, std::size_t);
+
+    DotKernel selectDot() {
+#ifdef SPECTRAL_AUDIT_X86
+        const CpuFeatures& cpu = CpuFeatures::get();
+        if (cpu.avx2)
+            return dotAvx2;
+        if (cpu.sse2)
+            return dotSse2;
+#endif
+        return dotScalar;
+    }
+
+    using DctTable = std::array<std::array<double, MelFilterbank::BANDS>, MelFilterbank::COEFFICIENTS>;
+
+    DctTable buildDct() {
+        DctTable table{};
+        const double n = MelFilterbank::BANDS;
+        for (int k = 0; k < MelFilterbank::COEFFICIENTS; ++k) {
+            const double scale = std::sqrt((k == 0 ? 1.0 : 2.0) / n);
+            for (int b = 0; b < MelFilterbank::BANDS; ++b)
+                table[k][b] = scale * std::cos(PI * k * (b + 0.5) / n);
+        }
+        return table;
+    }
+}
+
+const MelFilterbank& MelFilterbank::get(int sampleRate, int bins) {
+    return SpectrumTableCache<MelFilterbank>::get(sampleRate, bins);
+}
+
+MelFilterbank::MelFilterbank(int sampleRate, int bins)
+    : binCount(bins) {
+    if (bins < 2 || sampleRate <= 0)
+        return;
+
+    // Same bin spacing as FeatureExtractor: bin i sits at i * nyquist / (bins - 1).
+    const double nyquist = sampleRate * 0.5;
+    const double binHz = nyquist / (bins - 1);
+    const double maxMel = hzToMel(std::min(CONSTANTS::MEL_MAX_HZ, nyquist));
+    const double minMel = std::min(hzToMel(CONSTANTS::MEL_MIN_HZ), maxMel);
+
+    double edges[BANDS + 2];
+    for (int e = 0; e < BANDS + 2; ++e)
+        edges[e] = melToHz(minMel + (maxMel - minMel) * e / (BANDS + 1));
+
+    for (int b = 0; b < BANDS; ++b) {
+        const double left = edges[b], center = edges[b + 1], right = edges[b + 2];
+
+        // Bins strictly inside (left, right); the weight is 0 at both edges.
+        const int first = std::max(0, static_cast<int>(std::floor(left / binHz)) + 1);
+        const int last = std::min(bins - 1, static_cast<int>(std::ceil(right / binHz)) - 1);
+
+        Band& band = bands[b];
+        band.firstBin = first;
+        band.offset = weights.size();
+        for (int i = first; i <= last; ++i) {
+            const double hz = i * binHz;
+            const double w = hz <= center ? (hz - left) / (center - left) : (right - hz) / (right - center);
+            weights.push_back(static_cast<Sample>(std::max(0.0, w)));
+        }
+        band.count = std::max(0, last - first + 1);
+    }
+}
+
+void MelFilterbank::bandEnergies(const Sample* power, Sample* out) const {
+    static const DotKernel dot = selectDot();
+
+    for (int b = 0; b < BANDS; ++b) {
+        const Band& band = bands[b];
+        out[b] = band.count > 0 ? dot(weights.data() + band.offset, power + band.firstBin, static_cast<std::size_t>(band.count)) : 0;
+    }
+}
+
+void MelFilterbank::mfcc(const Sample* power, double* out) const {
+    static const DctTable dct = buildDct();
+
+    Sample energies[BANDS];
+    bandEnergies(power, energies);
+
+    double logEnergies[BANDS];
+    for (int b = 0; b < BANDS; ++b)
+        logEnergies[b] = std::log(static_cast<double>(energies[b]) + LOG_FLOOR);
+
+    for (int k = 0; k < COEFFICIENTS; ++k) {
+        double sum = 0.0;
+        for (int b = 0; b < BANDS; ++b)
+            sum += dct[k][b] * logEnergies[b];
+        out[k] = sum;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "SampleType.h"
+#include "SpectrumTableCache.h"
+#include "../Resources/Constants.h"
+
+/*
+ * Triangular mel bands over a power spectrum and the MFCCs derived from them.
+ * Each band only covers the bins under its triangle, so the band matrix is stored sparse: one run of weights per band,
+ * applied as a dot product with the matching run of bins. The dot products keep eight partials (bin i % 8) combined in
+ * a fixed order, so the SSE2 and AVX2 kernels give the scalar loop's result bit for bit.
+ * A filterbank depends only on the sample rate and the bin count; get() builds each one once, see SpectrumTableCache.
+ */
+class MelFilterbank {
+public:
+    static constexpr int BANDS = CONSTANTS::MEL_BANDS;
+    static constexpr int COEFFICIENTS = CONSTANTS::MFCC_COEFFICIENTS;
+
+    // Lives until the process exits.
+    static const MelFilterbank& get(int sampleRate, int bins);
+
+    // BANDS energies from a power spectrum of bins() bins.
+    void bandEnergies(const Sample* power, Sample* out) const;
+    // COEFFICIENTS MFCCs: the orthonormal DCT-II of the log band energies, c0 included.
+    void mfcc(const Sample* power, double* out) const;
+
+    int bins() const { return binCount; }
+
+private:
+    friend class SpectrumTableCache<MelFilterbank>;
+    MelFilterbank(int sampleRate, int bins);
+
+    struct Band {
+        int firstBin = 0;
+        int count = 0; // bins with a nonzero weight; 0 when the band falls between two bins
+        std::size_t offset = 0; // into weights
+    };
+
+    int binCount;
+    Band bands[BANDS];
+    std::vector<Sample> weights;
+};
@@ -1,26 +1,126 @@
 #include "Mp3Decoder.h"
 
 #define MINIMP3_IMPLEMENTATION
+#ifdef SPECTRAL_AUDIT_MP3_FLOAT
+#define MINIMP3_FLOAT_OUTPUT
+#endif
 #pragma warning(push)
 #pragma warning(disable : 4267 4244 6385 6386 6262)
 #include <iostream>
 
 #include "../Third Party/minimp3.h"
 #include "../Third Party/minimp3_ex.h"
-#include "../Utilities/BlackMetalSanitizer.h"
 #pragma warning(pop)
 
-bool Mp3Decoder::decodeMp3Mono(const std::string& path, std::vector<double>& samples, int& sampleRate) {
-    mp3dec_t decoder{};
-    mp3dec_file_info_t info{};
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstring>
 
-    mp3dec_init(&decoder);
+#include "PcmCache.h"
+#include "PcmConverter.h"
+#include "../Queue/WorkerPool.h"
+#include "../Resources/Constants.h"
+
+struct Mp3Decoder::Stream {
+    mp3dec_ex_t decoder{};
+    std::vector<mp3d_sample_t> pcm;
+    bool opened = false;
+};
+
+Mp3Decoder::Mp3Decoder()
+    : stream(std::make_unique<Stream>()) {
+}
+
+Mp3Decoder::~Mp3Decoder() {
+    close();
+}
+
+// The caller keeps data alive until close().
+bool Mp3Decoder::open(const std::uint8_t* data, std::size_t size) {
+    close();
+
+    if (mp3dec_ex_open_buf(&stream->decoder, data, size, MP3D_SEEK_TO_SAMPLE) != 0)
+        return false;
+
+    return finishOpen();
+}
+
+bool Mp3Decoder::finishOpen() {
+    stream->opened = true;
+
+    if (stream->decoder.info.channels <= 0 || stream->decoder.info.hz <= 0) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+std::size_t Mp3Decoder::readMono(Sample* out, std::size_t maxFrames) {
+    if (!stream->opened || maxFrames == 0)
+        return 0;
+
+    const size_t ch = static_cast<size_t>(stream->decoder.info.channels);
+    stream->pcm.resize(maxFrames * ch);
+
+    const size_t read = mp3dec_ex_read(&stream->decoder, stream->pcm.data(), stream->pcm.size());
+    const size_t frameCount = read / ch;
+
+    PcmConverter::downmixToMono(stream->pcm.data(), frameCount, static_cast<int>(ch), out);
+    return frameCount;
+}
+
+std::size_t Mp3Decoder::readMidSide(Sample* mid, Sample* side, std::size_t maxFrames) {
+    if (!stream->opened || maxFrames == 0)
+        return 0;
+
+    const size_t ch = static_cast<size_t>(stream->decoder.info.channels);
+    stream->pcm.resize(maxFrames * ch);
 
-    if (mp3dec_load(&decoder, path.c_str(), &info, nullptr, nullptr) != 0)
+    const size_t read = mp3dec_ex_read(&stream->decoder, stream->pcm.data(), stream->pcm.size());
+    const size_t frameCount = read / ch;
+
+    PcmConverter::splitMidSide(stream->pcm.data(), frameCount, static_cast<int>(ch), mid, side);
+    return frameCount;
+}
+
+// Sample-accurate: mp3dec_ex re-decodes enough preceding frames to refill the bit reservoir.
+bool Mp3Decoder::seek(std::uint64_t frame) {
+    if (!stream->opened)
         return false;
 
+    return mp3dec_ex_seek(&stream->decoder, frame * static_cast<std::uint64_t>(stream->decoder.info.channels)) == 0;
+}
+
+void Mp3Decoder::close() {
+    if (!stream->opened)
+        return;
+
+    mp3dec_ex_close(&stream->decoder);
+    stream->opened = false;
+}
+
+bool Mp3Decoder::failed() const {
+    return stream->decoder.last_error != 0;
+}
+
+int Mp3Decoder::getSampleRate() const {
+    return stream->decoder.info.hz;
+}
+
+int Mp3Decoder::getChannels() const {
+    return stream->decoder.info.channels;
+}
+
+std::uint64_t Mp3Decoder::getTotalFrames() const {
+    const int channels = stream->decoder.info.channels;
+    return channels > 0 ? stream->decoder.samples / static_cast<std::uint64_t>(channels) : 0;
+}
+
+static bool downmixLoaded(mp3dec_file_info_t& info, std::vector<Sample>& samples, int& sampleRate, int& channels) {
     sampleRate = info.hz;
-    const int channels = info.channels;
+    channels = info.channels;
 
     if (channels <= 0 || sampleRate <= 0 || info.samples <= 0 || info.buffer == nullptr) {
         if (info.buffer) std::free(info.buffer);
@@ -32,36 +132,371 @@ bool Mp3Decoder::decodeMp3Mono(const std::string& path, std::vector<double>& sam
     const size_t frameCount = total / ch;
 
     samples.resize(frameCount);
+    PcmConverter::downmixToMono(info.buffer, frameCount, channels, samples.data());
+
+    std::free(info.buffer);
+    return true;
+}
+
+namespace {
+    // One frame of the stream as mp3dec_load_buf walks it.
+    struct ScannedFrame {
+        std::size_t offset;
+        std::uint32_t bytes;
+        std::uint32_t samples; // per channel, 0 where the serial decoder drops the frame
+    };
 
-    for (size_t frame = 0; frame < frameCount; ++frame) {
-        const size_t base = frame * ch;
-        double sum = 0.0;
-        for (size_t c = 0; c < ch; ++c)
-            sum += info.buffer[base + c];
-        samples[frame] = (sum / static_cast<double>(channels)) / 32768.0;
+    struct FrameScan {
+        std::vector<ScannedFrame> frames;
+        std::vector<std::uint64_t> firstSample; // per frame, before the encoder delay is removed
+        int channels = 0;
+        int sampleRate = 0;
+        std::uint64_t skip = 0;  // encoder delay from the LAME tag
+        std::uint64_t total = 0; // frames of output after the delay and padding are removed
+    };
+
+    // Bytes of main data a frame contributes to the bit reservoir.
+    std::uint32_t mainDataBytes(const std::uint8_t* hdr, std::uint32_t frameBytes) {
+        const std::uint32_t sideInfo = HDR_TEST_MPEG1(hdr) ? (HDR_IS_MONO(hdr) ? 17 : 32) : (HDR_IS_MONO(hdr) ? 9 : 17);
+        const std::uint32_t overhead = HDR_SIZE + (HDR_IS_CRC(hdr) ? 2 : 0) + sideInfo;
+        return frameBytes > overhead ? frameBytes - overhead : 0;
+    }
+}
+
+// Header-only walk that lands on exactly the frames mp3dec_load_buf decodes: same ID3 and VBR-tag handling, and the
+// same decoder reset on corrupt side info. Anything the serial loader would reject or treat specially (layers I/II,
+// sample-rate or channel changes) fails the scan, and the caller decodes serially.
+static bool scanFrames(const std::uint8_t* data, std::size_t size, FrameScan& scan) {
+    const std::uint8_t* buf = data;
+    std::size_t bufSize = size;
+
+    mp3dec_skip_id3(&buf, &bufSize);
+    if (bufSize == 0)
+        return false;
+
+    int frameSize = 0;
+    for (;;) {
+        int freeFormatBytes = 0;
+        const int i = mp3d_find_frame(buf, static_cast<int>(std::min<std::size_t>(bufSize, INT_MAX)), &freeFormatBytes, &frameSize);
+        buf += i;
+        bufSize -= i;
+
+        if (frameSize)
+            break;
+        if (!i)
+            return false;
+    }
+
+    if (4 - HDR_GET_LAYER(buf) != 3)
+        return false;
+
+    scan.channels = HDR_IS_MONO(buf) ? 1 : 2;
+    scan.sampleRate = hdr_sample_rate_hz(buf);
+
+    std::uint32_t tagFrames = 0;
+    int delay = 0;
+    int padding = 0;
+    std::uint64_t detected = 0;
+
+    const int tag = mp3dec_check_vbrtag(buf, frameSize, &tagFrames, &delay, &padding);
+    if (tag > 0) {
+        scan.skip = static_cast<std::uint64_t>(delay);
+        detected = static_cast<std::uint64_t>(hdr_frame_samples(buf)) * tagFrames;
+        detected = detected >= scan.skip ? detected - scan.skip : detected;
+        if (padding > 0 && detected >= static_cast<std::uint64_t>(padding))
+            detected -= padding;
+        if (!detected)
+            return false;
+    }
+    if (tag) {
+        buf += frameSize;
+        bufSize -= frameSize;
+    }
+
+    mp3dec_t dec;
+    mp3dec_init(&dec);
+    mp3dec_frame_info_t info{};
+    std::uint64_t produced = 0;
+
+    do {
+        info.frame_offset = -1;
+        const int samples = mp3dec_decode_frame(&dec, buf, static_cast<int>(std::min<std::size_t>(bufSize, INT_MAX)), nullptr, &info);
+
+        if (samples && info.frame_offset >= 0) {
+            const std::uint8_t* hdr = buf + info.frame_offset;
+            const int bytes = info.frame_bytes - info.frame_offset;
+
+            if (info.layer != 3)
+                return false;
+
+            bs_t bs[1];
+            L3_gr_info_t grInfo[4];
+            bs_init(bs, hdr + HDR_SIZE, bytes - HDR_SIZE);
+            if (HDR_IS_CRC(hdr))
+                get_bits(bs, 16);
+
+            std::uint32_t emitted = static_cast<std::uint32_t>(samples);
+            if (L3_read_side_info(bs, grInfo, hdr) < 0 || bs->pos > bs->limit) {
+                mp3dec_init(&dec);
+                emitted = 0;
+            }
+            else if (info.hz != scan.sampleRate || info.channels != scan.channels) {
+                return false;
+            }
+
+            scan.frames.push_back({ static_cast<std::size_t>(hdr - data), static_cast<std::uint32_t>(bytes), emitted });
+            scan.firstSample.push_back(produced);
+            produced += emitted;
+        }
+
+        buf += info.frame_bytes;
+        bufSize -= info.frame_bytes;
+    } while (info.frame_bytes);
+
+    scan.total = produced > scan.skip ? produced - scan.skip : 0;
+    if (detected && scan.total > detected)
+        scan.total = detected;
+
+    return scan.total > 0;
+}
+
+// Frames decoded before the reservoir-filling ones, so the IMDCT overlap and the filterbank history come from fully
+// decoded granules.
+static constexpr std::size_t WARMUP_FRAMES = 3;
+
+// Decodes frames [first, last) of the scan into their place in out. A fresh decoder starts at `warmup`, early enough
+// that the bit reservoir holds every byte the first kept frame can reach back to and the IMDCT overlap and synthesis
+// filterbank have been refilled, so from `first` on it is in the serial decoder's exact state.
+// The backup is an estimate, so it is checked: a frame past the first WARMUP_FRAMES that decodes short found its
+// reservoir incomplete, and then the state at `first` cannot be trusted either.
+static bool decodeFrameRange(const std::uint8_t* data, std::size_t size, const FrameScan& scan,
+    std::size_t warmup, std::size_t first, std::size_t last, Sample* out) {
+    const std::size_t verifiedFrom = std::min(first, warmup + WARMUP_FRAMES);
+
+    mp3dec_t dec;
+    mp3dec_init(&dec);
+    mp3dec_frame_info_t info{};
+    mp3d_sample_t pcm[MINIMP3_MAX_SAMPLES_PER_FRAME];
+
+    const std::size_t ch = static_cast<std::size_t>(scan.channels);
+    std::size_t position = scan.frames[warmup].offset;
+    std::size_t index = warmup;
+
+    while (index < last) {
+        info.frame_offset = -1;
+        const int samples = mp3dec_decode_frame(&dec, data + position, static_cast<int>(std::min<std::size_t>(size - position, INT_MAX)), pcm, &info);
+        if (!info.frame_bytes)
+            return false;
+
+        if (info.frame_offset >= 0) {
+            // Off the serial decoder's path: the split cannot be trusted.
+            const ScannedFrame& frame = scan.frames[index];
+            if (position + info.frame_offset != frame.offset)
+                return false;
+
+            if (index >= verifiedFrom && static_cast<std::uint32_t>(samples) != frame.samples)
+                return false;
+
+            if (index >= first) {
+                // Drop what falls into the encoder delay or the padding, as mp3dec_load_buf does.
+                const std::uint64_t begin = scan.firstSample[index];
+                const std::uint64_t from = std::max(begin, scan.skip);
+                const std::uint64_t to = std::min(begin + frame.samples, scan.skip + scan.total);
+
+                if (from < to) {
+                    PcmConverter::downmixToMono(pcm + (from - begin) * ch, static_cast<std::size_t>(to - from),
+                        scan.channels, out + (from - scan.skip));
+                }
+            }
+            ++index;
+        }
+
+        position += info.frame_bytes;
     }
 
-    std::free(info.buffer);
     return true;
 }
 
+// Splits the scanned frames into up to PARALLEL_DECODE_THREADS chunks run on the pool; without one, or when a chunk
+// fails its checks, the frames are decoded as one serial chunk.
+static bool decodeScanned(const std::uint8_t* data, std::size_t size, const FrameScan& scan, WorkerPool* pool, DecodedAudio& out) {
+    const std::size_t frameCount = scan.frames.size();
+    const std::size_t chunks = !pool ? 1 : std::clamp<std::size_t>(
+        std::min<std::size_t>(CONSTANTS::PARALLEL_DECODE_THREADS, frameCount / CONSTANTS::PARALLEL_DECODE_MIN_CHUNK_FRAMES), 1, frameCount);
+
+    out.samples.resize(static_cast<std::size_t>(scan.total));
+    out.sampleRate = scan.sampleRate;
+    out.channels = scan.channels;
+
+    std::vector<std::size_t> bounds(chunks + 1);
+    for (std::size_t c = 0; c <= chunks; ++c)
+        bounds[c] = frameCount * c / chunks;
+
+    std::atomic<bool> ok{ true };
+    auto decodeChunk = [&](std::size_t c) {
+        const std::size_t first = bounds[c];
+
+        // Enough preceding main data to fill the 511-byte reservoir, then three more frames, so the IMDCT overlap
+        // and the filterbank history are rebuilt from fully decoded granules before the first kept frame.
+        std::size_t warmup = first;
+        std::uint32_t reservoir = 0;
+        while (warmup > 0 && reservoir < MAX_BITRESERVOIR_BYTES) {
+            --warmup;
+            reservoir += mainDataBytes(data + scan.frames[warmup].offset, scan.frames[warmup].bytes);
+        }
+        warmup -= std::min(warmup, WARMUP_FRAMES);
+
+        if (!decodeFrameRange(data, size, scan, warmup, first, bounds[c + 1], out.samples.data()))
+            ok.store(false, std::memory_order_relaxed);
+    };
+
+    if (chunks == 1) {
+        decodeChunk(0);
+        return ok.load();
+    }
+
+    pool->parallelFor(chunks, decodeChunk);
+    if (ok.load())
+        return true;
+
+    ok.store(true);
+    bounds = { 0, frameCount };
+    decodeChunk(0);
+    return ok.load();
+}
+
+bool Mp3Decoder::decodeParallel(const std::uint8_t* data, std::size_t size, DecodedAudio& out, WorkerPool& pool) {
+    FrameScan scan;
+    return scanFrames(data, size, scan) && decodeScanned(data, size, scan, &pool, out);
+}
+
+// mp3dec_load_buf and a separate downmix pass.
+static bool decodeLoaded(const std::uint8_t* data, std::size_t size, DecodedAudio& out) {
+    mp3dec_t decoder{};
+    mp3dec_file_info_t info{};
+
+    mp3dec_init(&decoder);
+
+    if (mp3dec_load_buf(&decoder, data, size, &info, nullptr, nullptr) != 0)
+        return false;
+
+    return downmixLoaded(info, out.samples, out.sampleRate, out.channels);
+}
 
-std::optional<DecodedAudio> Mp3Decoder::decode(const std::filesystem::path& path, std::size_t minSamples) {
+bool Mp3Decoder::decodeReference(const std::uint8_t* data, std::size_t size, DecodedAudio& out) {
+    return decodeLoaded(data, size, out);
+}
+
+// Decodes frame by frame straight into the mono buffer, so the interleaved PCM of the whole track never exists.
+// Streams the frame walk cannot follow go through mp3dec_load_buf instead.
+static bool decodeBuffer(const std::uint8_t* data, std::size_t size, DecodedAudio& out, WorkerPool* pool) {
+    FrameScan scan;
+    if (scanFrames(data, size, scan) && decodeScanned(data, size, scan, pool, out))
+        return true;
+
+    return decodeLoaded(data, size, out);
+}
+
+bool Mp3Decoder::decodeMp3Mono(const std::uint8_t* data, std::size_t size, std::vector<Sample>& samples, int& sampleRate) {
     DecodedAudio out;
+    out.samples.swap(samples);
 
-    auto safePath = BlackMetalSanitizer::makeSafeTempCopy(path);
-    const bool ok = decodeMp3Mono(safePath.string(), out.samples, out.sampleRate);
-    BlackMetalSanitizer::cleanup(safePath);
+    const bool ok = decodeBuffer(data, size, out, nullptr);
+    samples.swap(out.samples);
+    sampleRate = out.sampleRate;
+    return ok;
+}
 
-    if (!ok) {
-        std::cerr << "Decode failed: " << path << '\n';
-        return std::nullopt;
+
+RejectReason Mp3Decoder::probe(const std::uint8_t* data, std::size_t size, std::size_t minSamples) {
+    const std::uint8_t* buf = data;
+    std::size_t bufSize = size;
+
+    mp3dec_skip_id3(&buf, &bufSize);
+    if (bufSize == 0)
+        return RejectReason::Empty;
+
+    // The decoder's own sync rule, a run of consistent headers, limited to the start of the file.
+    int freeFormatBytes = 0;
+    int frameSize = 0;
+    const int offset = mp3d_find_frame(buf, static_cast<int>(std::min(bufSize, CONSTANTS::PROBE_SYNC_BYTES)), &freeFormatBytes, &frameSize);
+    if (!frameSize)
+        return RejectReason::NoSync;
+
+    const std::uint8_t* first = buf + offset;
+    const std::size_t available = bufSize - offset;
+
+    // hdr_compare, which the sync run is checked with, ignores the channel mode; a change there fails the decode.
+    std::size_t position = 0;
+    for (int i = 0; i < MAX_FRAME_SYNC_MATCHES && position + HDR_SIZE <= available; ++i) {
+        const std::uint8_t* hdr = first + position;
+        if (!hdr_valid(hdr) || !hdr_compare(first, hdr))
+            break;
+        if (HDR_IS_MONO(hdr) != HDR_IS_MONO(first))
+            return RejectReason::FormatChange;
+
+        position += hdr_frame_bytes(hdr, freeFormatBytes) + hdr_padding(hdr);
     }
 
-    if (out.samples.size() < minSamples) {
-        std::cerr << "Too short: " << path << '\n';
-        return std::nullopt;
+    const std::uint64_t frameSamples = hdr_frame_samples(first);
+
+    std::uint32_t tagFrames = 0;
+    int delay = 0;
+    int padding = 0;
+    if (4 - HDR_GET_LAYER(first) == 3 && static_cast<std::size_t>(frameSize) <= available
+        && mp3dec_check_vbrtag(first, frameSize, &tagFrames, &delay, &padding) > 0) {
+        // Exact, the same arithmetic mp3dec_load_buf trims with.
+        std::uint64_t samples = frameSamples * tagFrames;
+        samples = samples >= static_cast<std::uint64_t>(delay) ? samples - delay : samples;
+        if (padding > 0 && samples >= static_cast<std::uint64_t>(padding))
+            samples -= padding;
+
+        return samples < minSamples ? RejectReason::TooShort : RejectReason::None;
     }
 
+    // Without a tag only a bound is known: every remaining byte spent at the lowest bitrate.
+    std::uint8_t lowest[HDR_SIZE];
+    std::memcpy(lowest, first, HDR_SIZE);
+    lowest[2] = static_cast<std::uint8_t>((lowest[2] & 0x0F) | 0x10);
+    const std::uint64_t minFrameBytes = static_cast<std::uint64_t>(std::max(hdr_frame_bytes(lowest, 0), 1));
+
+    return (available / minFrameBytes + 1) * frameSamples < minSamples ? RejectReason::TooShort : RejectReason::None;
+}
+
+static bool checkDecoded(bool ok, const std::filesystem::path& path) {
+    if (!ok)
+        std::cerr << "Decode failed: " << path << '\n';
+
+    return ok;
+}
+
+std::optional<DecodedAudio> Mp3Decoder::decode(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path) {
+    DecodedAudio out;
+    if (!decode(data, size, path, out))
+        return std::nullopt;
+
     return out;
 }
+
+bool Mp3Decoder::decode(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path, DecodedAudio& out, WorkerPool* pool) {
+    return checkDecoded(decodeBuffer(data, size, out, pool), path);
+}
+
+bool Mp3Decoder::decode(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path, DecodedAudio& out, PcmCache& cache, WorkerPool* pool) {
+#ifdef SPECTRAL_AUDIT_MP3_FLOAT
+    // Float output is not an int16 channel sum, so it cannot be stored, and entries from an int16 build would not
+    // match what this build decodes.
+    (void)cache;
+    return decode(data, size, path, out, pool);
+#else
+    const std::uint64_t key = PcmCache::contentHash(data, size);
+    if (cache.load(key, out))
+        return true;
+
+    if (!decode(data, size, path, out, pool))
+        return false;
+
+    cache.store(key, out);
+    return true;
+#endif
+}
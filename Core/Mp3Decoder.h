@@ -1,16 +1,70 @@
 #pragma once
+#include <cstdint>
 #include <filesystem>
-#include <string>
+#include <memory>
 #include <vector>
 #include <optional>
 
+#include "AudioDecoder.h"
+#include "SampleType.h"
+#include "../Model/TrackData.h"
+
+class PcmCache;
+class WorkerPool;
+
 struct DecodedAudio {
-    std::vector<double> samples;
+    std::vector<Sample> samples;
     int sampleRate = 0;
+    int channels = 0; // of the source, before the downmix
 };
 
-class Mp3Decoder {
+/*
+ * MP3 through minimp3, either streamed chunk by chunk or decoded whole into one mono buffer.
+ * Define SPECTRAL_AUDIT_MP3_FLOAT to build minimp3 with float output: samples skip the int16 round trip, and peaks of
+ * loud masters above full scale are kept instead of clipped. That build does not use the PCM cache.
+ */
+class Mp3Decoder : public AudioDecoder {
 public:
-	static bool decodeMp3Mono(const std::string& path, std::vector<double>& samples, int& sampleRate);
-    static std::optional<DecodedAudio>decode(const std::filesystem::path& path,std::size_t minSamples);
+    Mp3Decoder();
+    ~Mp3Decoder() override;
+
+    Mp3Decoder(const Mp3Decoder&) = delete;
+    Mp3Decoder& operator=(const Mp3Decoder&) = delete;
+
+    // Streaming mode: decodes frame by frame through mp3dec_ex, never holding more than one chunk of PCM.
+    bool open(const std::uint8_t* data, std::size_t size) override;
+    std::size_t readMono(Sample* out, std::size_t maxFrames) override;
+    std::size_t readMidSide(Sample* mid, Sample* side, std::size_t maxFrames) override;
+    bool seek(std::uint64_t frame) override;
+    void close() override;
+
+    bool failed() const override;
+    int getSampleRate() const override;
+    int getChannels() const override;
+    std::uint64_t getTotalFrames() const override;
+
+    static bool decodeMp3Mono(const std::uint8_t* data, std::size_t size, std::vector<Sample>& samples, int& sampleRate);
+    static std::optional<DecodedAudio>decode(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path);
+    // Decode into a caller-owned buffer whose capacity is kept between tracks. With a pool, long streams are split as
+    // decodeParallel does. Too short a result is the caller's to reject, as it is for the streaming decoders.
+    static bool decode(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path, DecodedAudio& out, WorkerPool* pool = nullptr);
+    // Splits the stream at frame boundaries and decodes up to PARALLEL_DECODE_THREADS pieces on the pool, each starting
+    // a few frames early so its bit reservoir and filterbank state match the serial decoder's. A piece whose warmup
+    // frames do not all decode in full makes the whole stream decode serially. Returns false for streams the frame walk
+    // cannot follow at all. --check-parallel-decode compares the result with decodeReference sample for sample.
+    static bool decodeParallel(const std::uint8_t* data, std::size_t size, DecodedAudio& out, WorkerPool& pool);
+    // mp3dec_load_buf and a separate downmix: the serial decode every other path must reproduce.
+    static bool decodeReference(const std::uint8_t* data, std::size_t size, DecodedAudio& out);
+    // Header-only check run before anything expensive: ID3v2 skip, frame sync near the start, the channel count of
+    // the first frames, and the duration from the VBR tag or else an upper bound from the byte count. None means the
+    // file is worth decoding, not that it will decode.
+    static RejectReason probe(const std::uint8_t* data, std::size_t size, std::size_t minSamples);
+    // Looks the bytes up in the cache first; a miss decodes as above and stores the result.
+    static bool decode(const std::uint8_t* data, std::size_t size, const std::filesystem::path& path, DecodedAudio& out, PcmCache& cache, WorkerPool* pool = nullptr);
+
+private:
+    bool finishOpen();
+
+    struct Stream;
+    std::unique_ptr<Stream> stream;
 };
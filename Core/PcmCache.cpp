@@ -0,0 +1,341 @@
+#include "PcmCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../Utilities/MappedFile.h"
+
+namespace {
+    // Bump whenever the entry layout or the decoder's output changes; older entries then fail validation.
+    constexpr std::uint32_t FORMAT_VERSION = 1;
+    constexpr char MAGIC[4] = { 'S', 'A', 'P', 'C' };
+
+    // Native byte order; the cache is not meant to move between machines.
+    struct Header {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t key;
+        std::uint64_t frames;
+        std::uint32_t sampleRate;
+        std::uint32_t channels;
+        std::uint64_t checksum;
+    };
+    static_assert(sizeof(Header) == 40, "cache header must have no padding");
+
+    std::uint64_t payloadBytes(std::uint64_t frames, std::uint32_t channels) {
+        return frames * sizeof(std::int16_t) + (channels == 2 ? (frames + 7) / 8 : 0);
+    }
+
+    constexpr std::uint64_t PRIME1 = 0x9E3779B185EBCA87ull;
+    constexpr std::uint64_t PRIME2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr std::uint64_t PRIME3 = 0x165667B19E3779F9ull;
+    constexpr std::uint64_t PRIME4 = 0x85EBCA77C2B2AE63ull;
+    constexpr std::uint64_t PRIME5 = 0x27D4EB2F165667C5ull;
+
+    std::uint64_t rotl(std::uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    std::uint64_t read64(const std::uint8_t* p) {
+        std::uint64_t v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    std::uint32_t read32(const std::uint8_t* p) {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof v);
+        return v;
+    }
+
+    std::uint64_t hashRound(std::uint64_t acc, std::uint64_t input) {
+        acc += input * PRIME2;
+        return rotl(acc, 31) * PRIME1;
+    }
+
+    std::uint64_t mergeRound(std::uint64_t acc, std::uint64_t value) {
+        acc ^= hashRound(0, value);
+        return acc * PRIME1 + PRIME4;
+    }
+}
+
+PcmCache::PcmCache(std::filesystem::path directory, std::uint64_t capacityBytes)
+    : directory(std::move(directory)),
+    capacityBytes(capacityBytes) {
+    namespace fs = std::filesystem;
+
+    std::error_code ec;
+    fs::create_directories(this->directory, ec);
+
+    // Rebuild the LRU order from the previous runs' write times; half-written entries are dropped.
+    // Stepped with increment(ec), since the range-for's operator++ throws on a directory that fails mid-listing.
+    std::vector<std::pair<fs::file_time_type, std::pair<std::uint64_t, std::uint64_t>>> found;
+    for (fs::directory_iterator it(this->directory, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::directory_entry& entry = *it;
+        const fs::path& path = entry.path();
+        std::error_code entryEc;
+
+        if (path.extension() == ".tmp") {
+            fs::remove(path, entryEc);
+            continue;
+        }
+        if (path.extension() != ".pcm" || !entry.is_regular_file(entryEc))
+            continue;
+
+        const std::string stem = path.stem().string();
+        char* stemEnd = nullptr;
+        const std::uint64_t key = std::strtoull(stem.c_str(), &stemEnd, 16);
+        if (stem.size() != 16 || stemEnd != stem.c_str() + stem.size())
+            continue;
+
+        const auto time = entry.last_write_time(entryEc);
+        const auto bytes = entry.file_size(entryEc);
+        if (!entryEc)
+            found.push_back({ time, { key, bytes } });
+    }
+
+    std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [time, entry] : found)
+        insert(entry.first, entry.second);
+
+    // The budget may have been lowered since the last run, and a run that only hits the cache never stores.
+    for (std::uint64_t old : evictOverBudget(0))
+        fs::remove(entryPath(old), ec);
+}
+
+// XXH64 with seed 0.
+std::uint64_t PcmCache::contentHash(const std::uint8_t* data, std::size_t size) {
+    const std::uint8_t* p = data;
+    const std::uint8_t* const end = data + size;
+    std::uint64_t h;
+
+    if (size >= 32) {
+        std::uint64_t v1 = PRIME1 + PRIME2;
+        std::uint64_t v2 = PRIME2;
+        std::uint64_t v3 = 0;
+        std::uint64_t v4 = 0 - PRIME1;
+
+        const std::uint8_t* const limit = end - 32;
+        do {
+            v1 = hashRound(v1, read64(p));
+            v2 = hashRound(v2, read64(p + 8));
+            v3 = hashRound(v3, read64(p + 16));
+            v4 = hashRound(v4, read64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else {
+        h = PRIME5;
+    }
+
+    h += static_cast<std::uint64_t>(size);
+
+    for (; p + 8 <= end; p += 8)
+        h = rotl(h ^ hashRound(0, read64(p)), 27) * PRIME1 + PRIME4;
+
+    if (p + 4 <= end) {
+        h = rotl(h ^ (static_cast<std::uint64_t>(read32(p)) * PRIME1), 23) * PRIME2 + PRIME3;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+        h = rotl(h ^ (*p * PRIME5), 11) * PRIME1;
+
+    h ^= h >> 33;
+    h *= PRIME2;
+    h ^= h >> 29;
+    h *= PRIME3;
+    h ^= h >> 32;
+    return h;
+}
+
+std::filesystem::path PcmCache::entryPath(std::uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof name, "%016llx.pcm", static_cast<unsigned long long>(key));
+    return directory / name;
+}
+
+bool PcmCache::load(std::uint64_t key, DecodedAudio& out) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (entries.find(key) == entries.end())
+            return false;
+    }
+
+    const std::filesystem::path path = entryPath(key);
+    MappedFile file;
+    bool valid = file.open(path) && file.size() >= sizeof(Header);
+
+    Header header{};
+    if (valid) {
+        std::memcpy(&header, file.data(), sizeof header);
+
+        valid = std::memcmp(header.magic, MAGIC, sizeof MAGIC) == 0
+            && header.version == FORMAT_VERSION
+            && header.key == key
+            && (header.channels == 1 || header.channels == 2)
+            && header.sampleRate > 0
+            && file.size() == sizeof(Header) + payloadBytes(header.frames, header.channels)
+            && contentHash(file.data() + sizeof(Header), file.size() - sizeof(Header)) == header.checksum;
+    }
+
+    if (!valid) {
+        file.close();
+
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        forget(key);
+        return false;
+    }
+
+    const std::size_t frames = static_cast<std::size_t>(header.frames);
+    const std::uint8_t* halves = file.data() + sizeof(Header);
+    const std::uint8_t* parity = halves + frames * sizeof(std::int16_t);
+    const bool stereo = header.channels == 2;
+
+    // The same power-of-two scale PcmConverter applies to the channel sum, so the result is exact.
+    const double scale = 1.0 / (32768.0 * header.channels);
+
+    out.samples.resize(frames);
+    for (std::size_t i = 0; i < frames; ++i) {
+        std::int16_t half;
+        std::memcpy(&half, halves + i * sizeof half, sizeof half);
+
+        std::int32_t sum = half;
+        if (stereo)
+            sum = sum * 2 + ((parity[i / 8] >> (i % 8)) & 1);
+
+        out.samples[i] = static_cast<Sample>(sum * scale);
+    }
+    out.sampleRate = static_cast<int>(header.sampleRate);
+    out.channels = static_cast<int>(header.channels);
+    file.close();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        touch(key);
+    }
+
+    std::error_code ec;
+    std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+    return true;
+}
+
+void PcmCache::store(std::uint64_t key, const DecodedAudio& audio) {
+    if ((audio.channels != 1 && audio.channels != 2) || audio.sampleRate <= 0 || audio.samples.empty())
+        return;
+
+    const std::uint32_t channels = static_cast<std::uint32_t>(audio.channels);
+    const std::uint64_t frames = audio.samples.size();
+    const bool stereo = channels == 2;
+
+    std::vector<std::uint8_t> bytes(sizeof(Header) + payloadBytes(frames, channels), 0);
+    std::uint8_t* halves = bytes.data() + sizeof(Header);
+    std::uint8_t* parity = halves + frames * sizeof(std::int16_t);
+
+    const double unscale = 32768.0 * channels;
+    for (std::size_t i = 0; i < audio.samples.size(); ++i) {
+        const double scaled = static_cast<double>(audio.samples[i]) * unscale;
+        const std::int32_t sum = static_cast<std::int32_t>(std::lround(scaled));
+
+        // Anything that is not a channel sum of int16 PCM cannot be reproduced exactly, so it is not cached.
+        if (static_cast<double>(sum) != scaled || sum < -32768 * static_cast<std::int32_t>(channels) || sum > 32767 * static_cast<std::int32_t>(channels))
+            return;
+
+        const std::int16_t half = static_cast<std::int16_t>(stereo ? (sum >> 1) : sum);
+        std::memcpy(halves + i * sizeof half, &half, sizeof half);
+        if (stereo && (sum & 1))
+            parity[i / 8] |= static_cast<std::uint8_t>(1u << (i % 8));
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof MAGIC);
+    header.version = FORMAT_VERSION;
+    header.key = key;
+    header.frames = frames;
+    header.sampleRate = static_cast<std::uint32_t>(audio.sampleRate);
+    header.channels = channels;
+    header.checksum = contentHash(halves, bytes.size() - sizeof(Header));
+    std::memcpy(bytes.data(), &header, sizeof header);
+
+    // Written under a unique name and renamed into place, so a reader never sees a partial entry.
+    static std::atomic<std::uint64_t> sequence{ 0 };
+    const std::filesystem::path path = entryPath(key);
+    std::filesystem::path temp = path;
+    temp += "." + std::to_string(sequence.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size())))
+            return;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp, ec);
+        return;
+    }
+
+    std::vector<std::uint64_t> evicted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        insert(key, bytes.size());
+
+        // The entry just written stays even if it alone is over budget.
+        evicted = evictOverBudget(1);
+    }
+
+    for (std::uint64_t old : evicted)
+        std::filesystem::remove(entryPath(old), ec);
+}
+
+// The callers hold the mutex for the four below.
+std::vector<std::uint64_t> PcmCache::evictOverBudget(std::size_t keep) {
+    std::vector<std::uint64_t> evicted;
+    while (totalBytes > capacityBytes && recency.size() > keep) {
+        evicted.push_back(recency.back());
+        forget(recency.back());
+    }
+    return evicted;
+}
+
+void PcmCache::touch(std::uint64_t key) {
+    const auto it = entries.find(key);
+    if (it != entries.end())
+        recency.splice(recency.begin(), recency, it->second.recency);
+}
+
+void PcmCache::forget(std::uint64_t key) {
+    const auto it = entries.find(key);
+    if (it == entries.end())
+        return;
+
+    totalBytes -= it->second.bytes;
+    recency.erase(it->second.recency);
+    entries.erase(it);
+}
+
+void PcmCache::insert(std::uint64_t key, std::uint64_t bytes) {
+    forget(key);
+
+    recency.push_front(key);
+    entries[key] = Entry{ bytes, recency.begin() };
+    totalBytes += bytes;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Mp3Decoder.h"
+
+/*
+ * On-disk cache of decoded mono PCM, keyed by a hash of the encoded file's bytes, so re-analysis runs skip decoding.
+ * Entries store the integer channel sum the downmix is computed from: 16 bits per frame plus one parity bit for
+ * stereo. A hit therefore reproduces the decoder's samples bit for bit, in either precision build.
+ * Files carry a checksum over the payload; a damaged entry is deleted and counts as a miss. Once the cache exceeds
+ * its byte budget the least recently used entries go, with recency carried across runs in the files' write times.
+ * Safe to share between workers.
+ */
+class PcmCache {
+public:
+    PcmCache(std::filesystem::path directory, std::uint64_t capacityBytes);
+
+    PcmCache(const PcmCache&) = delete;
+    PcmCache& operator=(const PcmCache&) = delete;
+
+    static std::uint64_t contentHash(const std::uint8_t* data, std::size_t size);
+
+    bool load(std::uint64_t key, DecodedAudio& out);
+    // Only mono and stereo int16 sources are representable; anything else is silently not stored.
+    void store(std::uint64_t key, const DecodedAudio& audio);
+
+private:
+    struct Entry {
+        std::uint64_t bytes = 0;
+        std::list<std::uint64_t>::iterator recency;
+    };
+
+    std::filesystem::path entryPath(std::uint64_t key) const;
+    void touch(std::uint64_t key);
+    void forget(std::uint64_t key);
+    void insert(std::uint64_t key, std::uint64_t bytes);
+    // Drops least recently used entries from the index until the budget holds or only `keep` remain; the caller
+    // deletes the returned keys' files, outside the lock.
+    std::vector<std::uint64_t> evictOverBudget(std::size_t keep);
+
+    std::filesystem::path directory;
+    std::uint64_t capacityBytes;
+
+    std::mutex mutex;
+    std::list<std::uint64_t> recency; // most recent first
+    std::unordered_map<std::uint64_t, Entry> entries;
+    std::uint64_t totalBytes = 0;
+};
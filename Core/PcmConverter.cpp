@@ -0,0 +1,256 @@
+#include "PcmConverter.h"
+
+#include <algorithm>
+
+#include "../Utilities/CpuFeatures.h"
+
+#ifdef SPECTRAL_AUDIT_X86
+#include <immintrin.h>
+#endif
+
+// Channel sums are exact integers and 1 / (channels * 32768) is a power of two for mono and stereo,
+// so every kernel produces bit-identical output to the scalar loop.
+static double scaleFor(int channels) {
+    return 1.0 / (32768.0 * channels);
+}
+
+static void downmixScalar(const std::int16_t* in, std::size_t frames, int channels, Sample* out) {
+    const double scale = scaleFor(channels);
+    const std::size_t ch = static_cast<std::size_t>(channels);
+
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        const std::int16_t* f = in + frame * ch;
+        std::int32_t sum = 0;
+        for (std::size_t c = 0; c < ch; ++c)
+            sum += f[c];
+        out[frame] = static_cast<Sample>(sum * scale);
+    }
+}
+
+#ifdef SPECTRAL_AUDIT_X86
+
+SIMD_TARGET("sse2")
+static inline void storeSums(Sample* out, __m128i sums, double scale) {
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(sums), _mm_set1_ps(static_cast<float>(scale))));
+#else
+    const __m128d s = _mm_set1_pd(scale);
+    _mm_storeu_pd(out, _mm_mul_pd(_mm_cvtepi32_pd(sums), s));
+    _mm_storeu_pd(out + 2, _mm_mul_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(sums, sums)), s));
+#endif
+}
+
+SIMD_TARGET("sse2")
+static void downmixSse2(const std::int16_t* in, std::size_t frames, int channels, Sample* out) {
+    const double scale = scaleFor(channels);
+    std::size_t frame = 0;
+
+    if (channels == 2) {
+        const __m128i ones = _mm_set1_epi16(1);
+        for (; frame + 4 <= frames; frame += 4) {
+            const __m128i lr = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + frame * 2));
+            storeSums(out + frame, _mm_madd_epi16(lr, ones), scale);
+        }
+    }
+    else if (channels == 1) {
+        for (; frame + 8 <= frames; frame += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + frame));
+            storeSums(out + frame, _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16), scale);
+            storeSums(out + frame + 4, _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16), scale);
+        }
+    }
+
+    downmixScalar(in + frame * channels, frames - frame, channels, out + frame);
+}
+
+SIMD_TARGET("avx2")
+static inline void storeSums(Sample* out, __m256i sums, double scale) {
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(sums), _mm256_set1_ps(static_cast<float>(scale))));
+#else
+    const __m256d s = _mm256_set1_pd(scale);
+    _mm256_storeu_pd(out, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sums)), s));
+    _mm256_storeu_pd(out + 4, _mm256_mul_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sums, 1)), s));
+#endif
+}
+
+SIMD_TARGET("avx2")
+static void downmixAvx2(const std::int16_t* in, std::size_t frames, int channels, Sample* out) {
+    const double scale = scaleFor(channels);
+    std::size_t frame = 0;
+
+    if (channels == 2) {
+        const __m256i ones = _mm256_set1_epi16(1);
+        for (; frame + 8 <= frames; frame += 8) {
+            const __m256i lr = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + frame * 2));
+            storeSums(out + frame, _mm256_madd_epi16(lr, ones), scale);
+        }
+    }
+    else if (channels == 1) {
+        for (; frame + 8 <= frames; frame += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + frame));
+            storeSums(out + frame, _mm256_cvtepi16_epi32(v), scale);
+        }
+    }
+
+    downmixScalar(in + frame * channels, frames - frame, channels, out + frame);
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+static inline void storeSums(Sample* out, __m512i sums, double scale) {
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    _mm512_storeu_ps(out, _mm512_mul_ps(_mm512_cvtepi32_ps(sums), _mm512_set1_ps(static_cast<float>(scale))));
+#else
+    const __m512d s = _mm512_set1_pd(scale);
+    _mm512_storeu_pd(out, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_castsi512_si256(sums)), s));
+    _mm512_storeu_pd(out + 8, _mm512_mul_pd(_mm512_cvtepi32_pd(_mm512_extracti64x4_epi64(sums, 1)), s));
+#endif
+}
+
+SIMD_TARGET("avx512f,avx512bw")
+static void downmixAvx512(const std::int16_t* in, std::size_t frames, int channels, Sample* out) {
+    const double scale = scaleFor(channels);
+    std::size_t frame = 0;
+
+    if (channels == 2) {
+        const __m512i ones = _mm512_set1_epi16(1);
+        for (; frame + 16 <= frames; frame += 16) {
+            const __m512i lr = _mm512_loadu_si512(in + frame * 2);
+            storeSums(out + frame, _mm512_madd_epi16(lr, ones), scale);
+        }
+    }
+    else if (channels == 1) {
+        for (; frame + 16 <= frames; frame += 16) {
+            const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + frame));
+            storeSums(out + frame, _mm512_cvtepi16_epi32(v), scale);
+        }
+    }
+
+    downmixScalar(in + frame * channels, frames - frame, channels, out + frame);
+}
+
+#endif
+
+void PcmConverter::downmixToMono(const std::int16_t* interleaved, std::size_t frames, int channels, Sample* out) {
+    static const Kernel kernel = bestKernel();
+    downmixToMono(kernel, interleaved, frames, channels, out);
+}
+
+void PcmConverter::downmixToMono(Kernel kernel, const std::int16_t* interleaved, std::size_t frames, int channels, Sample* out) {
+    if (channels <= 0)
+        return;
+
+    switch (kernel) {
+#ifdef SPECTRAL_AUDIT_X86
+    case Kernel::Avx512:
+        downmixAvx512(interleaved, frames, channels, out);
+        return;
+    case Kernel::Avx2:
+        downmixAvx2(interleaved, frames, channels, out);
+        return;
+    case Kernel::Sse2:
+        downmixSse2(interleaved, frames, channels, out);
+        return;
+#endif
+    default:
+        downmixScalar(interleaved, frames, channels, out);
+        return;
+    }
+}
+
+void PcmConverter::splitMidSide(const std::int16_t* interleaved, std::size_t frames, int channels, Sample* mid, Sample* side) {
+    if (channels <= 0)
+        return;
+
+    downmixToMono(interleaved, frames, channels, mid);
+
+    if (channels == 1) {
+        std::fill(side, side + frames, Sample{ 0 });
+        return;
+    }
+
+    const double scale = scaleFor(2);
+    const std::size_t ch = static_cast<std::size_t>(channels);
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        const std::int16_t* f = interleaved + frame * ch;
+        side[frame] = static_cast<Sample>((static_cast<std::int32_t>(f[0]) - f[1]) * scale);
+    }
+}
+
+// Plain loops: the mono and stereo cases are simple enough for the compiler to vectorize.
+void PcmConverter::downmixToMono(const float* interleaved, std::size_t frames, int channels, Sample* out) {
+    if (channels <= 0)
+        return;
+
+    if (channels == 1) {
+        std::copy(interleaved, interleaved + frames, out);
+        return;
+    }
+
+    if (channels == 2) {
+        for (std::size_t frame = 0; frame < frames; ++frame)
+            out[frame] = (static_cast<Sample>(interleaved[2 * frame]) + interleaved[2 * frame + 1]) * Sample{ 0.5 };
+        return;
+    }
+
+    const double scale = 1.0 / channels;
+    const std::size_t ch = static_cast<std::size_t>(channels);
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        const float* f = interleaved + frame * ch;
+        double sum = 0.0;
+        for (std::size_t c = 0; c < ch; ++c)
+            sum += f[c];
+        out[frame] = static_cast<Sample>(sum * scale);
+    }
+}
+
+void PcmConverter::splitMidSide(const float* interleaved, std::size_t frames, int channels, Sample* mid, Sample* side) {
+    if (channels <= 0)
+        return;
+
+    downmixToMono(interleaved, frames, channels, mid);
+
+    if (channels == 1) {
+        std::fill(side, side + frames, Sample{ 0 });
+        return;
+    }
+
+    const std::size_t ch = static_cast<std::size_t>(channels);
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        const float* f = interleaved + frame * ch;
+        side[frame] = (static_cast<Sample>(f[0]) - f[1]) * Sample{ 0.5 };
+    }
+}
+
+PcmConverter::Kernel PcmConverter::bestKernel() {
+    if (isSupported(Kernel::Avx512))
+        return Kernel::Avx512;
+    if (isSupported(Kernel::Avx2))
+        return Kernel::Avx2;
+    if (isSupported(Kernel::Sse2))
+        return Kernel::Sse2;
+    return Kernel::Scalar;
+}
+
+bool PcmConverter::isSupported(Kernel kernel) {
+#ifdef SPECTRAL_AUDIT_X86
+    const CpuFeatures& cpu = CpuFeatures::get();
+    switch (kernel) {
+    case Kernel::Avx512: return cpu.avx512;
+    case Kernel::Avx2: return cpu.avx2;
+    case Kernel::Sse2: return cpu.sse2;
+    default: return true;
+    }
+#else
+    return kernel == Kernel::Scalar;
+#endif
+}
+
+const wchar_t* PcmConverter::kernelName(Kernel kernel) {
+    switch (kernel) {
+    case Kernel::Avx512: return L"AVX-512";
+    case Kernel::Avx2: return L"AVX2";
+    case Kernel::Sse2: return L"SSE2";
+    default: return L"Scalar";
+    }
+}
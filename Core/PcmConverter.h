@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "SampleType.h"
+
+/*
+ * Interleaved int16 PCM -> mono samples in [-1, 1), converting and downmixing in one pass.
+ * Mono and stereo have SSE2/AVX2/AVX-512 kernels picked from the running CPU; other layouts use the scalar loop.
+ * The float overloads take decoder output that is already scaled to [-1, 1] but not clipped.
+ */
+class PcmConverter {
+public:
+    enum class Kernel { Scalar, Sse2, Avx2, Avx512 };
+
+    static void downmixToMono(const std::int16_t* interleaved, std::size_t frames, int channels, Sample* out);
+    static void downmixToMono(Kernel kernel, const std::int16_t* interleaved, std::size_t frames, int channels, Sample* out);
+    // mid is exactly downmixToMono's output; side is (L - R) / 2 of the first two channels, 0 for mono.
+    static void splitMidSide(const std::int16_t* interleaved, std::size_t frames, int channels, Sample* mid, Sample* side);
+
+    static void downmixToMono(const float* interleaved, std::size_t frames, int channels, Sample* out);
+    static void splitMidSide(const float* interleaved, std::size_t frames, int channels, Sample* mid, Sample* side);
+
+    static Kernel bestKernel();
+    static bool isSupported(Kernel kernel);
+    static const wchar_t* kernelName(Kernel kernel);
+};
@@ -0,0 +1,54 @@
+#include "PitchClassMap.h"
+
+#include <algorithm>
+#include <cmath>
+
+const PitchClassMap& PitchClassMap::get(int sampleRate, int bins) {
+    return SpectrumTableCache<PitchClassMap>::get(sampleRate, bins);
+}
+
+PitchClassMap::PitchClassMap(int sampleRate, int bins) {
+    if (bins < 2 || sampleRate <= 0)
+        return;
+
+    // Same bin spacing as FeatureExtractor: bin i sits at i * nyquist / (bins - 1).
+    const double nyquist = sampleRate * 0.5;
+    const double binHz = nyquist / (bins - 1);
+
+    // Below this, one bin spans more than a semitone and would smear its energy over neighbouring classes.
+    const double semitoneRatio = std::pow(2.0, 1.0 / 12.0) - 1.0;
+    const double minHz = std::max(CONSTANTS::CHROMA_MIN_HZ, binHz / semitoneRatio);
+    const double maxHz = std::min(CONSTANTS::CHROMA_MAX_HZ, nyquist);
+
+    const int first = static_cast<int>(std::ceil(minHz / binHz));
+    const int last = std::min(bins - 1, static_cast<int>(std::floor(maxHz / binHz)));
+
+    for (int i = std::max(first, 1); i <= last; ++i) {
+        // MIDI note numbering: 69 is A4, and multiples of 12 are Cs.
+        const long note = std::lround(69.0 + 12.0 * std::log2(i * binHz / 440.0));
+        const int pitchClass = static_cast<int>((note % PITCH_CLASSES + PITCH_CLASSES) % PITCH_CLASSES);
+
+        if (!runs.empty() && runs.back().pitchClass == pitchClass)
+            ++runs.back().count;
+        else
+            runs.push_back({ i, 1, pitchClass });
+    }
+}
+
+void PitchClassMap::chroma(const Sample* power, double* out) const {
+    double energy[PITCH_CLASSES] = {};
+    for (const Run& run : runs) {
+        Sample sum = 0;
+        for (int i = 0; i < run.count; ++i)
+            sum += power[run.firstBin + i];
+        energy[run.pitchClass] += sum;
+    }
+
+    double total = 0.0;
+    for (double e : energy)
+        total += e;
+
+    const double scale = total > 0.0 ? 1.0 / total : 0.0;
+    for (int pc = 0; pc < PITCH_CLASSES; ++pc)
+        out[pc] = energy[pc] * scale;
+}
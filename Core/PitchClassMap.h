@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+
+#include "SampleType.h"
+#include "SpectrumTableCache.h"
+#include "../Resources/Constants.h"
+
+/*
+ * Bin to pitch class mapping for chroma vectors. Each bin in the chroma range goes to the pitch class of its nearest
+ * equal-tempered semitone (A4 = 440 Hz), and consecutive bins of one class form a run, so a frame's chroma is one pass
+ * of contiguous sums over the mapped bins. Built once per sample rate and bin count, see SpectrumTableCache.
+ */
+class PitchClassMap {
+public:
+    static constexpr int PITCH_CLASSES = CONSTANTS::PITCH_CLASSES;
+
+    // Lives until the process exits.
+    static const PitchClassMap& get(int sampleRate, int bins);
+
+    // Energy per pitch class (0 = C) from a power spectrum of the map's bin count, normalized to sum to 1;
+    // all zero when the chroma range holds no energy.
+    void chroma(const Sample* power, double* out) const;
+
+private:
+    friend class SpectrumTableCache<PitchClassMap>;
+    PitchClassMap(int sampleRate, int bins);
+
+    struct Run {
+        int firstBin = 0;
+        int count = 0;
+        int pitchClass = 0;
+    };
+
+    std::vector<Run> runs; // in bin order
+};
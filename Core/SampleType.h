@@ -0,0 +1,20 @@
+#pragma once
+
+#include <fftw3.h>
+
+/*
+ * Precision of the sample and spectrum pipeline (decode, STFT, per-frame features).
+ * Define SPECTRAL_AUDIT_FLOAT32 to build it on float and fftwf_*, which halves the memory traffic of the hot loops.
+ * Frame features and aggregated statistics stay double in both builds.
+ */
+#ifdef SPECTRAL_AUDIT_FLOAT32
+using Sample = float;
+using FftwComplex = fftwf_complex;
+using FftwPlan = fftwf_plan;
+#define FFTW(name) fftwf_##name
+#else
+using Sample = double;
+using FftwComplex = fftw_complex;
+using FftwPlan = fftw_plan;
+#define FFTW(name) fftw_##name
+#endif
@@ -0,0 +1,56 @@
+#include "SpectrogramMatrix.h"
+
+#include <new>
+#include <utility>
+
+SpectrogramMatrix::SpectrogramMatrix(std::size_t frames, std::size_t bins) {
+    resize(frames, bins);
+}
+
+SpectrogramMatrix::~SpectrogramMatrix() {
+    release();
+}
+
+SpectrogramMatrix::SpectrogramMatrix(SpectrogramMatrix&& other) noexcept
+    : block(std::exchange(other.block, nullptr)),
+    capacity(std::exchange(other.capacity, 0)),
+    frameCount(std::exchange(other.frameCount, 0)),
+    binCount(std::exchange(other.binCount, 0)),
+    rowStride(std::exchange(other.rowStride, 0)) {
+}
+
+SpectrogramMatrix& SpectrogramMatrix::operator=(SpectrogramMatrix&& other) noexcept {
+    if (this != &other) {
+        release();
+        block = std::exchange(other.block, nullptr);
+        capacity = std::exchange(other.capacity, 0);
+        frameCount = std::exchange(other.frameCount, 0);
+        binCount = std::exchange(other.binCount, 0);
+        rowStride = std::exchange(other.rowStride, 0);
+    }
+    return *this;
+}
+
+void SpectrogramMatrix::resize(std::size_t frames, std::size_t bins) {
+    constexpr std::size_t perLine = ALIGNMENT / sizeof(Sample);
+    const std::size_t stride = (bins + perLine - 1) / perLine * perLine;
+    const std::size_t needed = frames * stride;
+
+    if (needed > capacity) {
+        release();
+        block = static_cast<Sample*>(::operator new(needed * sizeof(Sample), std::align_val_t{ ALIGNMENT }));
+        capacity = needed;
+    }
+
+    frameCount = frames;
+    binCount = bins;
+    rowStride = stride;
+}
+
+void SpectrogramMatrix::release() {
+    if (block)
+        ::operator delete(block, std::align_val_t{ ALIGNMENT });
+
+    block = nullptr;
+    capacity = 0;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include "SampleType.h"
+
+/*
+ * Frames x bins magnitudes in one 64-byte-aligned block, row-major. Rows are padded to a multiple of 64 bytes,
+ * so every row starts on a cache line and the feature loops can use aligned loads.
+ * resize() keeps the block when the new shape fits, so a matrix reused across tracks allocates only while growing.
+ */
+class SpectrogramMatrix {
+public:
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    // One bin across frames; stride() elements apart.
+    class Column {
+    public:
+        Column(const Sample* first, std::size_t stride, std::size_t size)
+            : first(first), stride(stride), count(size) {
+        }
+
+        Sample operator[](std::size_t frame) const { return first[frame * stride]; }
+        std::size_t size() const { return count; }
+
+    private:
+        const Sample* first;
+        std::size_t stride;
+        std::size_t count;
+    };
+
+    SpectrogramMatrix() = default;
+    SpectrogramMatrix(std::size_t frames, std::size_t bins);
+    ~SpectrogramMatrix();
+
+    SpectrogramMatrix(SpectrogramMatrix&& other) noexcept;
+    SpectrogramMatrix& operator=(SpectrogramMatrix&& other) noexcept;
+    SpectrogramMatrix(const SpectrogramMatrix&) = delete;
+    SpectrogramMatrix& operator=(const SpectrogramMatrix&) = delete;
+
+    // Contents are unspecified afterwards.
+    void resize(std::size_t frames, std::size_t bins);
+
+    std::span<Sample> row(std::size_t frame) { return { block + frame * rowStride, binCount }; }
+    std::span<const Sample> row(std::size_t frame) const { return { block + frame * rowStride, binCount }; }
+    Column column(std::size_t bin) const { return { block + bin, rowStride, frameCount }; }
+
+    Sample* data() { return block; }
+    const Sample* data() const { return block; }
+
+    std::size_t frames() const { return frameCount; }
+    std::size_t bins() const { return binCount; }
+    std::size_t stride() const { return rowStride; }
+    bool empty() const { return frameCount == 0 || binCount == 0; }
+
+private:
+    void release();
+
+    Sample* block = nullptr;
+    std::size_t capacity = 0; // elements
+    std::size_t frameCount = 0;
+    std::size_t binCount = 0;
+    std::size_t rowStride = 0;
+};
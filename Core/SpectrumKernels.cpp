@@ -0,0 +1,185 @@
+#include "SpectrumKernels.h"
+
+#include <cmath>
+
+#include "../Utilities/CpuFeatures.h"
+
+#ifdef SPECTRAL_AUDIT_X86
+#include <immintrin.h>
+#endif
+
+// FFTW's complex type is two Samples, re then im, so a spectrum is an interleaved Sample array.
+static const Sample* interleaved(const FftwComplex* spectrum) {
+    return reinterpret_cast<const Sample*>(spectrum);
+}
+
+static void powerScalar(const Sample* in, std::size_t bins, Sample* out) {
+    for (std::size_t bin = 0; bin < bins; ++bin) {
+        const Sample re = in[2 * bin];
+        const Sample im = in[2 * bin + 1];
+        out[bin] = re * re + im * im;
+    }
+}
+
+static void magnitudesScalar(const Sample* in, std::size_t count, Sample* out) {
+    for (std::size_t i = 0; i < count; ++i)
+        out[i] = std::sqrt(in[i]);
+}
+
+#ifdef SPECTRAL_AUDIT_X86
+
+SIMD_TARGET("sse2")
+static void powerSse2(const Sample* in, std::size_t bins, Sample* out) {
+    std::size_t bin = 0;
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    for (; bin + 4 <= bins; bin += 4) {
+        const __m128 a = _mm_loadu_ps(in + 2 * bin);
+        const __m128 b = _mm_loadu_ps(in + 2 * bin + 4);
+        const __m128 a2 = _mm_mul_ps(a, a);
+        const __m128 b2 = _mm_mul_ps(b, b);
+        const __m128 re2 = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(2, 0, 2, 0));
+        const __m128 im2 = _mm_shuffle_ps(a2, b2, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + bin, _mm_add_ps(re2, im2));
+    }
+#else
+    for (; bin + 2 <= bins; bin += 2) {
+        const __m128d a = _mm_loadu_pd(in + 2 * bin);
+        const __m128d b = _mm_loadu_pd(in + 2 * bin + 2);
+        const __m128d a2 = _mm_mul_pd(a, a);
+        const __m128d b2 = _mm_mul_pd(b, b);
+        _mm_storeu_pd(out + bin, _mm_add_pd(_mm_unpacklo_pd(a2, b2), _mm_unpackhi_pd(a2, b2)));
+    }
+#endif
+    powerScalar(in + 2 * bin, bins - bin, out + bin);
+}
+
+SIMD_TARGET("sse2")
+static void magnitudesSse2(const Sample* in, std::size_t count, Sample* out) {
+    std::size_t i = 0;
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(_mm_loadu_ps(in + i)));
+#else
+    for (; i + 2 <= count; i += 2)
+        _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(in + i)));
+#endif
+    magnitudesScalar(in + i, count - i, out + i);
+}
+
+// hadd sums the squares pairwise within 128-bit lanes; the 64-bit permute puts the lanes back in bin order.
+SIMD_TARGET("avx2")
+static void powerAvx2(const Sample* in, std::size_t bins, Sample* out) {
+    std::size_t bin = 0;
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    for (; bin + 8 <= bins; bin += 8) {
+        const __m256 a = _mm256_loadu_ps(in + 2 * bin);
+        const __m256 b = _mm256_loadu_ps(in + 2 * bin + 8);
+        const __m256 sums = _mm256_hadd_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b));
+        _mm256_storeu_ps(out + bin, _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(sums), 0xD8)));
+    }
+#else
+    for (; bin + 4 <= bins; bin += 4) {
+        const __m256d a = _mm256_loadu_pd(in + 2 * bin);
+        const __m256d b = _mm256_loadu_pd(in + 2 * bin + 4);
+        const __m256d sums = _mm256_hadd_pd(_mm256_mul_pd(a, a), _mm256_mul_pd(b, b));
+        _mm256_storeu_pd(out + bin, _mm256_permute4x64_pd(sums, 0xD8));
+    }
+#endif
+    powerScalar(in + 2 * bin, bins - bin, out + bin);
+}
+
+SIMD_TARGET("avx2")
+static void magnitudesAvx2(const Sample* in, std::size_t count, Sample* out) {
+    std::size_t i = 0;
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(out + i, _mm256_sqrt_ps(_mm256_loadu_ps(in + i)));
+#else
+    for (; i + 4 <= count; i += 4)
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(in + i)));
+#endif
+    magnitudesScalar(in + i, count - i, out + i);
+}
+
+SIMD_TARGET("avx512f")
+static void powerAvx512(const Sample* in, std::size_t bins, Sample* out) {
+    std::size_t bin = 0;
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    const __m512i evens = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    const __m512i odds = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    for (; bin + 16 <= bins; bin += 16) {
+        const __m512 a = _mm512_loadu_ps(in + 2 * bin);
+        const __m512 b = _mm512_loadu_ps(in + 2 * bin + 16);
+        const __m512 a2 = _mm512_mul_ps(a, a);
+        const __m512 b2 = _mm512_mul_ps(b, b);
+        _mm512_storeu_ps(out + bin, _mm512_add_ps(_mm512_permutex2var_ps(a2, evens, b2), _mm512_permutex2var_ps(a2, odds, b2)));
+    }
+#else
+    const __m512i evens = _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14);
+    const __m512i odds = _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15);
+    for (; bin + 8 <= bins; bin += 8) {
+        const __m512d a = _mm512_loadu_pd(in + 2 * bin);
+        const __m512d b = _mm512_loadu_pd(in + 2 * bin + 8);
+        const __m512d a2 = _mm512_mul_pd(a, a);
+        const __m512d b2 = _mm512_mul_pd(b, b);
+        _mm512_storeu_pd(out + bin, _mm512_add_pd(_mm512_permutex2var_pd(a2, evens, b2), _mm512_permutex2var_pd(a2, odds, b2)));
+    }
+#endif
+    powerScalar(in + 2 * bin, bins - bin, out + bin);
+}
+
+SIMD_TARGET("avx512f")
+static void magnitudesAvx512(const Sample* in, std::size_t count, Sample* out) {
+    std::size_t i = 0;
+#ifdef SPECTRAL_AUDIT_FLOAT32
+    for (; i + 16 <= count; i += 16)
+        _mm512_storeu_ps(out + i, _mm512_sqrt_ps(_mm512_loadu_ps(in + i)));
+#else
+    for (; i + 8 <= count; i += 8)
+        _mm512_storeu_pd(out + i, _mm512_sqrt_pd(_mm512_loadu_pd(in + i)));
+#endif
+    magnitudesScalar(in + i, count - i, out + i);
+}
+
+#endif
+
+namespace {
+    using PowerKernel = void (*)(const Sample*, std::size_t, Sample*);
+    using MagnitudeKernel = void (*)(const Sample*, std::size_t, Sample*);
+
+    PowerKernel selectPower() {
+#ifdef SPECTRAL_AUDIT_X86
+        const CpuFeatures& cpu = CpuFeatures::get();
+        if (cpu.avx512)
+            return powerAvx512;
+        if (cpu.avx2)
+            return powerAvx2;
+        if (cpu.sse2)
+            return powerSse2;
+#endif
+        return powerScalar;
+    }
+
+    MagnitudeKernel selectMagnitudes() {
+#ifdef SPECTRAL_AUDIT_X86
+        const CpuFeatures& cpu = CpuFeatures::get();
+        if (cpu.avx512)
+            return magnitudesAvx512;
+        if (cpu.avx2)
+            return magnitudesAvx2;
+        if (cpu.sse2)
+            return magnitudesSse2;
+#endif
+        return magnitudesScalar;
+    }
+}
+
+void SpectrumKernels::power(const FftwComplex* spectrum, std::size_t bins, Sample* out) {
+    static const PowerKernel kernel = selectPower();
+    kernel(interleaved(spectrum), bins, out);
+}
+
+void SpectrumKernels::magnitudes(const Sample* power, std::size_t count, Sample* out) {
+    static const MagnitudeKernel kernel = selectMagnitudes();
+    kernel(power, count, out);
+}
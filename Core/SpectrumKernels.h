@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstddef>
+
+#include "SampleType.h"
+
+/*
+ * Per-bin kernels on FFTW output: power (re^2 + im^2) and the square root that turns power into magnitude.
+ * SSE2/AVX2/AVX-512 kernels are picked from the running CPU. Both operations are exactly rounded per element,
+ * so every kernel gives the scalar loop's result bit for bit.
+ */
+class SpectrumKernels {
+public:
+    static void power(const FftwComplex* spectrum, std::size_t bins, Sample* out);
+    // out may be power itself.
+    static void magnitudes(const Sample* power, std::size_t count, Sample* out);
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+/*
+ * Read-only per-spectrum tables (MelFilterbank, PitchClassMap) that depend only on the sample rate and the bin count,
+ * built once per pair and shared until the process exits. Table needs a (sampleRate, bins) constructor accessible to
+ * this class. Every frame asks, so each thread remembers its last few answers rather than taking the lock; a track's
+ * resolutions need one table each.
+ */
+template <typename Table>
+class SpectrumTableCache {
+public:
+    static const Table& get(int sampleRate, int bins) {
+        struct Hit {
+            int sampleRate = 0;
+            int bins = 0;
+            const Table* table = nullptr;
+        };
+        thread_local Hit hits[4];
+        thread_local std::size_t nextHit = 0;
+
+        for (const Hit& hit : hits) {
+            if (hit.table && hit.sampleRate == sampleRate && hit.bins == bins)
+                return *hit.table;
+        }
+
+        const Table* table;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            auto& slot = tables[{ sampleRate, bins }];
+            if (!slot)
+                slot.reset(new Table(sampleRate, bins));
+            table = slot.get();
+        }
+
+        hits[nextHit] = { sampleRate, bins, table };
+        nextHit = (nextHit + 1) % std::size(hits);
+        return *table;
+    }
+
+private:
+    static inline std::mutex mutex;
+    static inline std::map<std::pair<int, int>, std::unique_ptr<Table>> tables; // (sample rate, bins)
+};
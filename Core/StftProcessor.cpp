@@ -1,93 +1,175 @@
 #include "StftProcessor.h"
+#include <algorithm>
 #include <cmath>
-#include <mutex>
 #include <stdexcept>
 
-static constexpr double PI = 3.14159265358979323846;
+#include "FftPlanner.h"
+#include "SpectrumKernels.h"
+#include "../Resources/Constants.h"
+
+template <int N>
+static WindowKernels::Kernel fixedKernel(WindowFunction window) {
+    switch (window) {
+    case WindowFunction::Hamming: return FixedStft<N, WindowFunction::Hamming>::kernel();
+    case WindowFunction::BlackmanHarris: return FixedStft<N, WindowFunction::BlackmanHarris>::kernel();
+    case WindowFunction::Kaiser: return FixedStft<N, WindowFunction::Kaiser>::kernel();
+    default: return FixedStft<N, WindowFunction::Hann>::kernel();
+    }
+}
+
+// The window lengths the program runs get compile-time kernels; anything else takes the generic loop. The hop does
+// not enter the windowing, so it plays no part in the choice.
+static WindowKernels::Kernel selectWindowKernel(int windowSize, WindowFunction window) {
+    using namespace CONSTANTS;
+
+    if (windowSize == WINDOW_SIZE)
+        return fixedKernel<WINDOW_SIZE>(window);
+    if (windowSize == SHORT_WINDOW_SIZE)
+        return fixedKernel<SHORT_WINDOW_SIZE>(window);
+    if (windowSize == LONG_WINDOW_SIZE)
+        return fixedKernel<LONG_WINDOW_SIZE>(window);
 
-namespace {
-    std::mutex fftwPlannerMutex;
+    return WindowKernels::select<WindowKernels::Generic>();
 }
 
-StftProcessor::StftProcessor(int windowSize, int hopSize)
+StftProcessor::StftProcessor(int windowSize, int hopSize, int batchFrames, WindowFunction window)
     : windowSize(windowSize),
     hopSize(hopSize),
     frequencyBins(windowSize / 2 + 1),
-    fftInput(windowSize)
+    batchFrames(batchFrames),
+    windowFunction(window),
+    windowKernel(selectWindowKernel(windowSize, window)),
+    framePower(1, windowSize / 2 + 1),
+    batchSamples(batchFrames > 0 ? batchFrames : 0),
+    batchSumSquares(batchFrames > 0 ? batchFrames : 0),
+    batchPeaks(batchFrames > 0 ? batchFrames : 0)
 {
     if (windowSize < 2 || hopSize <= 0) {
         throw std::invalid_argument("Invalid windowSize or hopSize");
     }
+    if (batchFrames < 1) {
+        throw std::invalid_argument("Invalid batchFrames");
+    }
 
-    buildHannWindow();
+    buildWindow();
 
-    fftOutput = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * frequencyBins));
+    // FFTW's allocator, so the buffers have the alignment the shared plans were made for.
+    fftInput = static_cast<Sample*>(FFTW(malloc)(sizeof(Sample) * windowSize * batchFrames));
+    fftOutput = static_cast<FftwComplex*>(FFTW(malloc)(sizeof(FftwComplex) * frequencyBins * batchFrames));
 
-    if (!fftOutput) {
+    if (!fftInput || !fftOutput) {
+        FFTW(free)(fftInput);
+        FFTW(free)(fftOutput);
         throw std::runtime_error("FFTW allocation failed");
     }
 
-    {
-        std::lock_guard<std::mutex> lk(fftwPlannerMutex);
-        fftPlan = fftw_plan_dft_r2c_1d(windowSize, fftInput.data(), fftOutput, FFTW_ESTIMATE);
+    try {
+        fftPlan = FftPlanner::realForward(windowSize);
+        if (batchFrames > 1)
+            batchPlan = FftPlanner::realForwardBatch(windowSize, batchFrames);
     }
-
-    if (!fftPlan) {
-        fftw_free(fftOutput);
-        throw std::runtime_error("FFTW plan creation failed");
+    catch (...) {
+        FFTW(free)(fftInput);
+        FFTW(free)(fftOutput);
+        throw;
     }
 }
 
+// The plans are shared and owned by FftPlanner.
 StftProcessor::~StftProcessor() {
-    if (fftPlan) {
-        std::lock_guard<std::mutex> lk(fftwPlannerMutex);
-        fftw_destroy_plan(fftPlan);
-        fftPlan = nullptr;
-    }
-    if (fftOutput) {
-        fftw_free(fftOutput);
-        fftOutput = nullptr;
-    }
+    FFTW(free)(fftInput);
+    FFTW(free)(fftOutput);
 }
 
 
-void StftProcessor::buildHannWindow() {
-    hannWindow.resize(windowSize);
+// The same values a FixedStft table of this size holds.
+void StftProcessor::buildWindow() {
+    window.resize(windowSize);
     for (int n = 0; n < windowSize; ++n) {
-        hannWindow[n] = 0.5 * (1.0 - std::cos(2.0 * PI * n / (windowSize - 1)));
+        window[n] = static_cast<Sample>(WindowMath::window(windowFunction, n, windowSize));
     }
 }
 
-std::vector<std::vector<double>> StftProcessor::computeMagnitudes(const std::vector<double>& samples) {
+SpectrogramMatrix StftProcessor::computeMagnitudes(const std::vector<Sample>& samples) {
+    SpectrogramMatrix magnitudes;
+    computeMagnitudes(samples, magnitudes);
+    return magnitudes;
+}
+
+void StftProcessor::computeMagnitudes(const std::vector<Sample>& samples, SpectrogramMatrix& out) {
     const size_t total = samples.size();
     const size_t ws = static_cast<size_t>(windowSize);
     const size_t hs = static_cast<size_t>(hopSize);
 
-    if (total < ws) 
-        return {};
+    out.resize(total < ws ? 0 : 1 + (total - ws) / hs, static_cast<size_t>(frequencyBins));
 
-    const size_t frameCount = 1 + (total - ws) / hs;
+    const size_t batch = static_cast<size_t>(batchFrames);
+    size_t frame = 0;
 
-    std::vector<std::vector<double>> magnitudes(frameCount, std::vector<double>(static_cast<size_t>(frequencyBins)));
+    if (batch > 1) {
+        for (; frame + batch <= out.frames(); frame += batch) {
+            transformBatch(samples.data() + frame * hs);
+            for (size_t slot = 0; slot < batch; ++slot) {
+                const std::span<Sample> row = out.row(frame + slot);
+                batchFrame(slot, row);
+                SpectrumKernels::magnitudes(row.data(), row.size(), row.data());
+            }
+        }
+    }
 
-    for (size_t frame = 0; frame < frameCount; ++frame) {
-        const size_t offset = frame * hs;
+    for (; frame < out.frames(); ++frame) {
+        const std::span<Sample> row = out.row(frame);
+        computeFrame(samples.data() + frame * hs, row);
+        SpectrumKernels::magnitudes(row.data(), row.size(), row.data());
+    }
+}
 
-        for (size_t n = 0; n < ws; ++n)
-            fftInput[n] = samples[offset + n] * hannWindow[n];
+const StftFrame& StftProcessor::computeFrame(const Sample* frame) {
+    return computeFrame(frame, framePower.row(0));
+}
 
-        fftw_execute(fftPlan);
+const StftFrame& StftProcessor::computeFrame(const Sample* frame, std::span<Sample> power) {
+    Sample sumSquares = 0;
+    Sample peak = 0;
 
-        for (int bin = 0; bin < frequencyBins; ++bin) {
-            const double re = fftOutput[bin][0];
-            const double im = fftOutput[bin][1];
-            magnitudes[frame][static_cast<size_t>(bin)] = std::sqrt(re * re + im * im);
-        }
+    windowFrame(frame, fftInput, sumSquares, peak);
+    FFTW(execute_dft_r2c)(fftPlan, fftInput, fftOutput);
+    SpectrumKernels::power(fftOutput, power.size(), power.data());
+
+    currentFrame.index = 0;
+    currentFrame.samples = frame;
+    currentFrame.power = power;
+    currentFrame.sumSquares = sumSquares;
+    currentFrame.peak = peak;
+    return currentFrame;
+}
+
+void StftProcessor::transformBatch(const Sample* first) {
+    for (int slot = 0; slot < batchFrames; ++slot) {
+        const Sample* frame = first + static_cast<size_t>(slot) * hopSize;
+        batchSamples[slot] = frame;
+        batchSumSquares[slot] = 0;
+        batchPeaks[slot] = 0;
+        windowFrame(frame, fftInput + static_cast<size_t>(slot) * windowSize, batchSumSquares[slot], batchPeaks[slot]);
     }
 
-    return magnitudes;
+    FFTW(execute_dft_r2c)(batchPlan, fftInput, fftOutput);
+}
+
+const StftFrame& StftProcessor::batchFrame(std::size_t slot, std::span<Sample> power) {
+    SpectrumKernels::power(fftOutput + slot * frequencyBins, power.size(), power.data());
+
+    currentFrame.index = 0;
+    currentFrame.samples = batchSamples[slot];
+    currentFrame.power = power;
+    currentFrame.sumSquares = batchSumSquares[slot];
+    currentFrame.peak = batchPeaks[slot];
+    return currentFrame;
 }
 
+void StftProcessor::windowFrame(const Sample* frame, Sample* out, Sample& sumSquares, Sample& peak) const {
+    windowKernel(static_cast<size_t>(windowSize), frame, window.data(), out, sumSquares, peak);
+}
 
 int StftProcessor::getFrequencyBins() const {
     return frequencyBins;
@@ -100,3 +182,11 @@ int StftProcessor::getWindowSize() const {
 int StftProcessor::getHopSize() const {
     return hopSize;
 }
+
+int StftProcessor::getBatchFrames() const {
+    return batchFrames;
+}
+
+WindowFunction StftProcessor::getWindowFunction() const {
+    return windowFunction;
+}
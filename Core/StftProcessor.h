@@ -1,31 +1,106 @@
 ﻿#pragma once
 
+#include <cstddef>
+#include <span>
 #include <vector>
-#include <fftw3.h>
+
+#include "FixedStft.h"
+#include "SampleType.h"
+#include "SpectrogramMatrix.h"
+#include "WindowFunction.h"
+
+// One analyzed frame as a frame visitor sees it; the pointers are valid only during the call.
+struct StftFrame {
+    std::size_t index = 0;
+    const Sample* samples = nullptr; // windowSize input samples, before the window
+    std::span<const Sample> power; // re^2 + im^2 per bin; features that need magnitudes take the root themselves
+    Sample sumSquares = 0; // of samples, gathered in the windowing pass
+    Sample peak = 0;       // largest |sample|, likewise
+};
 
 class StftProcessor {
 public:
-    StftProcessor(int windowSize, int hopSize);
+    // batchFrames > 1 transforms that many consecutive frames with one FFTW call in forEachFrame and
+    // computeMagnitudes; single frames handed to computeFrame are unaffected.
+    // The main, short and long window sizes of Constants.h window through FixedStft kernels, any other size generically.
+    StftProcessor(int windowSize, int hopSize, int batchFrames = 1, WindowFunction window = WindowFunction::Hann);
     ~StftProcessor();
 
     StftProcessor(const StftProcessor&) = delete;
     StftProcessor& operator=(const StftProcessor&) = delete;
 
-    std::vector<std::vector<double>> computeMagnitudes(const std::vector<double>& samples);
+    // Window, FFT and power spectrum of every frame of samples in turn, each handed to visit(const StftFrame&) while it is
+    // still in cache. Only what the visitor keeps outlives the frame. Returns the number of frames.
+    template <typename Visitor>
+    std::size_t forEachFrame(const Sample* samples, std::size_t count, Visitor&& visit) {
+        const std::size_t ws = static_cast<std::size_t>(windowSize);
+        const std::size_t hs = static_cast<std::size_t>(hopSize);
+        if (count < ws)
+            return 0;
+
+        const std::size_t frameCount = 1 + (count - ws) / hs;
+        const std::size_t batch = static_cast<std::size_t>(batchFrames);
+        std::size_t frame = 0;
+
+        if (batch > 1) {
+            for (; frame + batch <= frameCount; frame += batch) {
+                transformBatch(samples + frame * hs);
+                for (std::size_t slot = 0; slot < batch; ++slot) {
+                    const StftFrame& f = batchFrame(slot, framePower.row(0));
+                    currentFrame.index = frame + slot;
+                    visit(f);
+                }
+            }
+        }
+
+        // The frames that do not fill a batch, or all of them when unbatched.
+        for (; frame < frameCount; ++frame) {
+            const StftFrame& f = computeFrame(samples + frame * hs);
+            currentFrame.index = frame;
+            visit(f);
+        }
+        return frameCount;
+    }
+
+    // The same for a single frame, e.g. one the FrameAssembler completed; index is left at 0.
+    const StftFrame& computeFrame(const Sample* frame);
+
+    // The full magnitude spectrogram, for consumers that need all of it at once such as SpectrogramPngWriter.
+    SpectrogramMatrix computeMagnitudes(const std::vector<Sample>& samples);
+    // Reuses out's block when the spectrogram fits in it.
+    void computeMagnitudes(const std::vector<Sample>& samples, SpectrogramMatrix& out);
 
     int getFrequencyBins() const;
     int getWindowSize() const;
     int getHopSize() const;
+    int getBatchFrames() const;
+    WindowFunction getWindowFunction() const;
 
 private:
-    void buildHannWindow();
+    void buildWindow();
+    const StftFrame& computeFrame(const Sample* frame, std::span<Sample> power);
+    void windowFrame(const Sample* frame, Sample* out, Sample& sumSquares, Sample& peak) const;
+
+    // Windows batchFrames frames hopSize apart starting at first and transforms them together.
+    void transformBatch(const Sample* first);
+    // Power spectrum of one slot of the last transformBatch.
+    const StftFrame& batchFrame(std::size_t slot, std::span<Sample> power);
 
     int windowSize;
     int hopSize;
     int frequencyBins;
+    int batchFrames;
+    WindowFunction windowFunction;
+    WindowKernels::Kernel windowKernel;
 
-    std::vector<double> hannWindow;
-    std::vector<double> fftInput;
-    fftw_complex* fftOutput;
-    fftw_plan fftPlan;
+    std::vector<Sample> window; // what the generic kernel reads
+    Sample* fftInput;          // batchFrames frames back to back; single frames use the first
+    SpectrogramMatrix framePower; // a single row
+    StftFrame currentFrame;
+    FftwComplex* fftOutput;    // likewise, frequencyBins apart
+    FftwPlan fftPlan;          // shared, see FftPlanner
+    FftwPlan batchPlan = nullptr; // batchFrames > 1 only
+    std::vector<const Sample*> batchSamples;
+    std::vector<Sample> batchSumSquares;
+    std::vector<Sample> batchPeaks;
 };
@@ -2,8 +2,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <functional>
 #include <numeric>
 
+#include "KeyEstimator.h"
+
 static FeatureStats computeStats(std::vector<double>& values) {
     FeatureStats featureStats{};
 
@@ -47,38 +50,121 @@ static FeatureStats computeStats(std::vector<double>& values) {
     return featureStats;
 }
 
+// The helpers below take a FrameFeatures member pointer or, for the MFCCs, one of these.
+static auto mfccCoefficient(int k) {
+    return [k](const FrameMfcc& f) { return f[k]; };
+}
+
+// One scratch vector serves every feature in turn; computeStats sorts it in place.
+template <typename Frame, typename Feature>
+static FeatureStats featureStats(const std::vector<Frame>& frames, Feature feature, std::vector<double>& scratch) {
+    scratch.clear();
+    for (const auto& f : frames)
+        scratch.push_back(std::invoke(feature, f));
+
+    return computeStats(scratch);
+}
+
+template <typename Frame, typename Feature>
+static double samplingError(const std::vector<Frame>& frames, const std::vector<std::size_t>& segmentEnds,
+    Feature feature, double sampledFraction) {
+    // Welford over the segment means, so nothing is allocated per track.
+    size_t n = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    std::size_t begin = 0;
+    for (std::size_t end : segmentEnds) {
+        if (end > begin) {
+            double sum = 0.0;
+            for (std::size_t i = begin; i < end; ++i)
+                sum += std::invoke(feature, frames[i]);
+
+            const double segmentMean = sum / (end - begin);
+            ++n;
+            const double d = segmentMean - mean;
+            mean += d / n;
+            m2 += d * (segmentMean - mean);
+        }
+        begin = end;
+    }
+
+    if (n < 2)
+        return 0.0;
+
+    const double variance = m2 / (n - 1);
+    const double fpc = std::clamp(1.0 - sampledFraction, 0.0, 1.0);
+    return std::sqrt(variance / n * fpc);
+}
+
+// Mean chroma over the frames, then the key that best fits it. Silent frames have all-zero chroma and only
+// scale the mean, which the key correlation ignores.
+void TrackAggregator::aggregateTonality(const std::vector<FrameChroma>& frames, TrackFeatures& out) {
+    out.hasTonality = true;
+
+    for (const FrameChroma& f : frames) {
+        for (int pc = 0; pc < CONSTANTS::PITCH_CLASSES; ++pc)
+            out.chroma[pc] += f[pc];
+    }
+
+    if (!frames.empty()) {
+        for (double& c : out.chroma)
+            c /= frames.size();
+    }
+
+    out.key = KeyEstimator::estimate(out.chroma);
+}
+
 TrackFeatures TrackAggregator::aggregate(const std::vector<FrameFeatures>& frames) {
+    std::vector<double> scratch;
+    return aggregate(frames, scratch);
+}
+
+TrackFeatures TrackAggregator::aggregate(const std::vector<FrameFeatures>& frames, std::vector<double>& scratch) {
     TrackFeatures out{};
 
-    std::vector<double>pcmRms, peak, spectralRms, centroid, rolloff, flatness, hfRatio;
-
-    const size_t size = frames.size();
-
-    pcmRms.reserve(size);
-    peak.reserve(size);
-    spectralRms.reserve(size);
-    centroid.reserve(size);
-    rolloff.reserve(size);
-    flatness.reserve(size);
-    hfRatio.reserve(size);
-
-    for (const auto& f : frames) {
-        pcmRms.push_back(f.pcmRms);
-        peak.push_back(f.peak);
-        spectralRms.push_back(f.spectralRms);
-        centroid.push_back(f.spectralCentroid);
-        rolloff.push_back(f.spectralRolloff85);
-        flatness.push_back(f.spectralFlatness);
-        hfRatio.push_back(f.hfRatio);
-    }
+    scratch.reserve(frames.size());
+
+    out.pcmRms = featureStats(frames, &FrameFeatures::pcmRms, scratch);
+    out.peak = featureStats(frames, &FrameFeatures::peak, scratch);
+    out.spectralRms = featureStats(frames, &FrameFeatures::spectralRms, scratch);
+    out.spectralCentroid = featureStats(frames, &FrameFeatures::spectralCentroid, scratch);
+    out.spectralRolloff85 = featureStats(frames, &FrameFeatures::spectralRolloff85, scratch);
+    out.spectralFlatness = featureStats(frames, &FrameFeatures::spectralFlatness, scratch);
+    out.hfRatio = featureStats(frames, &FrameFeatures::hfRatio, scratch);
+
+    return out;
+}
+
+TrackFeatures TrackAggregator::aggregate(const std::vector<FrameFeatures>& frames, const std::vector<std::size_t>& segmentEnds, double sampledFraction, std::vector<double>& scratch) {
+    TrackFeatures out = aggregate(frames, scratch);
 
-    out.pcmRms = computeStats(pcmRms);
-    out.peak = computeStats(peak);
-    out.spectralRms = computeStats(spectralRms);
-    out.spectralCentroid = computeStats(centroid);
-    out.spectralRolloff85 = computeStats(rolloff);
-    out.spectralFlatness = computeStats(flatness);
-    out.hfRatio = computeStats(hfRatio);
+    out.pcmRms.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::pcmRms, sampledFraction);
+    out.peak.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::peak, sampledFraction);
+    out.spectralRms.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::spectralRms, sampledFraction);
+    out.spectralCentroid.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::spectralCentroid, sampledFraction);
+    out.spectralRolloff85.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::spectralRolloff85, sampledFraction);
+    out.spectralFlatness.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::spectralFlatness, sampledFraction);
+    out.hfRatio.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::hfRatio, sampledFraction);
 
     return out;
-}
\ No newline at end of file
+}
+
+void TrackAggregator::aggregateMfcc(const std::vector<FrameMfcc>& frames, const std::vector<std::size_t>& segmentEnds, double sampledFraction, std::vector<double>& scratch, TrackFeatures& out) {
+    for (int k = 0; k < CONSTANTS::MFCC_COEFFICIENTS; ++k) {
+        out.mfcc[k] = featureStats(frames, mfccCoefficient(k), scratch);
+        out.mfcc[k].samplingError = samplingError(frames, segmentEnds, mfccCoefficient(k), sampledFraction);
+    }
+}
+
+void TrackAggregator::aggregateStereo(const std::vector<FrameFeatures>& frames, const std::vector<std::size_t>& segmentEnds, double sampledFraction, std::vector<double>& scratch, TrackFeatures& out) {
+    out.hasStereo = true;
+
+    out.interChannelCorrelation = featureStats(frames, &FrameFeatures::interChannelCorrelation, scratch);
+    out.stereoWidth = featureStats(frames, &FrameFeatures::stereoWidth, scratch);
+    out.sideEnergyRatio = featureStats(frames, &FrameFeatures::sideEnergyRatio, scratch);
+
+    out.interChannelCorrelation.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::interChannelCorrelation, sampledFraction);
+    out.stereoWidth.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::stereoWidth, sampledFraction);
+    out.sideEnergyRatio.samplingError = samplingError(frames, segmentEnds, &FrameFeatures::sideEnergyRatio, sampledFraction);
+}
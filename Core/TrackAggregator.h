@@ -6,4 +6,19 @@
 class TrackAggregator {
 public:
     static TrackFeatures aggregate(const std::vector<FrameFeatures>& frames);
+    // scratch is reused across tracks by the workers; its contents on return are unspecified.
+    static TrackFeatures aggregate(const std::vector<FrameFeatures>& frames, std::vector<double>& scratch);
+
+    // Survey mode: frames[segmentEnds[k-1], segmentEnds[k]) belong to segment k. Fills samplingError from
+    // the spread of the segment means, with a finite-population correction for the share of the track covered.
+    static TrackFeatures aggregate(const std::vector<FrameFeatures>& frames, const std::vector<std::size_t>& segmentEnds, double sampledFraction, std::vector<double>& scratch);
+
+    // Adds the stereo statistics to an aggregate of frames analyzed in stereo mode. segmentEnds may be empty.
+    static void aggregateStereo(const std::vector<FrameFeatures>& frames, const std::vector<std::size_t>& segmentEnds, double sampledFraction, std::vector<double>& scratch, TrackFeatures& out);
+
+    // Adds the MFCC statistics of the main resolution's frames. segmentEnds may be empty.
+    static void aggregateMfcc(const std::vector<FrameMfcc>& frames, const std::vector<std::size_t>& segmentEnds, double sampledFraction, std::vector<double>& scratch, TrackFeatures& out);
+
+    // Adds the mean chroma and the key of the tonal resolution's frames.
+    static void aggregateTonality(const std::vector<FrameChroma>& frames, TrackFeatures& out);
 };
\ No newline at end of file
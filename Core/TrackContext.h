@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "AudioDecoder.h"
+#include "FeatureExtractor.h"
+#include "FlacDecoder.h"
+#include "FrameAssembler.h"
+#include "Mp3Decoder.h"
+#include "SampleType.h"
+#include "StftProcessor.h"
+#include "WavDecoder.h"
+#include "../Model/TrackData.h"
+#include "../Resources/Constants.h"
+#include "../Utilities/FileBuffer.h"
+
+// Empties v, and frees its storage if it has grown past `retained` elements.
+template <typename T>
+void clearRetaining(std::vector<T>& v, std::size_t retained) {
+    if (v.capacity() > retained)
+        std::vector<T>().swap(v);
+    else
+        v.clear();
+}
+
+// Where the frames of one resolution go, each feature kind to its own vector; null for a kind it does not compute.
+// Every vector that is set holds the same frames.
+struct FrameOutputs {
+    std::vector<FrameFeatures>* features = nullptr;
+    std::vector<FrameMfcc>* mfcc = nullptr;
+    std::vector<FrameChroma>* chroma = nullptr;
+
+    std::size_t size() const {
+        return features ? features->size() : mfcc ? mfcc->size() : chroma ? chroma->size() : 0;
+    }
+
+    void resize(std::size_t frames) const {
+        if (features)
+            features->resize(frames);
+        if (mfcc)
+            mfcc->resize(frames);
+        if (chroma)
+            chroma->resize(frames);
+    }
+
+    void reserve(std::size_t frames) const {
+        if (features)
+            features->reserve(frames);
+        if (mfcc)
+            mfcc->reserve(frames);
+        if (chroma)
+            chroma->reserve(frames);
+    }
+};
+
+// One extra STFT resolution: its own processor and framing over the main resolution's samples.
+struct ResolutionContext {
+    ResolutionContext(StftResolution resolution, int stftBatchFrames, WindowFunction window, bool stored = true)
+        : resolution(resolution),
+        stored(stored),
+        stft(resolution.windowSize, resolution.hopSize, stftBatchFrames, window),
+        assembler(resolution.windowSize, resolution.hopSize) {
+    }
+
+    FrameOutputs outputs() {
+        return { stored ? &frameFeatures : nullptr, nullptr, chroma ? &frameChroma : nullptr };
+    }
+
+    StftResolution resolution;
+    bool stored; // mono features kept as a track_resolution_features block; false for the standalone tonal pass
+    bool chroma = false; // its frames give the track's chroma, see TrackContext::tonal
+    StftProcessor stft;
+    FrameAssembler assembler;
+    std::vector<FrameFeatures> frameFeatures;
+    std::vector<FrameChroma> frameChroma; // only when chroma is set
+    std::vector<std::size_t> segmentEnds; // survey mode
+};
+
+/*
+ * Everything one worker needs to analyze a track, kept from track to track.
+ * reset() empties the buffers without releasing them, so once they have grown to the longest track seen
+ * the DSP path no longer touches the heap. Buffers grown past RETAINED_DECODE_SAMPLES worth of audio are freed
+ * instead, so one long mix does not pin gigabytes in every worker that has met one.
+ */
+struct TrackContext {
+    TrackContext(int windowSize, int hopSize, int stftBatchFrames = 1, const std::vector<StftResolution>& extraResolutions = {},
+        WindowFunction window = WindowFunction::Hann, bool tonalPass = false)
+        : stft(windowSize, hopSize, stftBatchFrames, window),
+        sideStft(windowSize, hopSize, 1, window),
+        assembler(windowSize, hopSize),
+        chunk(CONSTANTS::DECODE_CHUNK_FRAMES) {
+        for (const StftResolution& resolution : extraResolutions) {
+            resolutions.push_back(std::make_unique<ResolutionContext>(resolution, stftBatchFrames, window));
+
+            if (!tonal && resolution.windowSize == CONSTANTS::LONG_WINDOW_SIZE && resolution.hopSize == CONSTANTS::LONG_HOP_SIZE)
+                tonal = resolutions.back().get();
+        }
+
+        if (!tonal && tonalPass) {
+            resolutions.push_back(std::make_unique<ResolutionContext>(
+                StftResolution{ CONSTANTS::LONG_WINDOW_SIZE, CONSTANTS::LONG_HOP_SIZE }, stftBatchFrames, window, false));
+            tonal = resolutions.back().get();
+        }
+
+        if (tonal)
+            tonal->chroma = true;
+    }
+
+    TrackContext(const TrackContext&) = delete;
+    TrackContext& operator=(const TrackContext&) = delete;
+
+    // Each format keeps its own decoder, so its state carries over to the next track of that format.
+    AudioDecoder& selectDecoder(AudioDecoder::Format format) {
+        switch (format) {
+        case AudioDecoder::Format::Wav:
+            decoder = &wavDecoder;
+            break;
+        case AudioDecoder::Format::Flac:
+            decoder = &flacDecoder;
+            break;
+        default:
+            decoder = &mp3Decoder;
+            break;
+        }
+        return *decoder;
+    }
+
+    void reset() {
+        decoder->close();
+        decoder = &mp3Decoder;
+        file.close();
+        assembler.reset();
+
+        clearRetaining(decoded.samples, CONSTANTS::RETAINED_DECODE_SAMPLES);
+        clearRetaining(frameFeatures, CONSTANTS::RETAINED_DECODE_SAMPLES / static_cast<std::size_t>(stft.getHopSize()));
+        clearRetaining(frameMfcc, CONSTANTS::RETAINED_DECODE_SAMPLES / static_cast<std::size_t>(stft.getHopSize()));
+        segmentEnds.clear();
+        for (auto& r : resolutions) {
+            r->assembler.reset();
+            clearRetaining(r->frameFeatures, CONSTANTS::RETAINED_DECODE_SAMPLES / static_cast<std::size_t>(r->resolution.hopSize));
+            clearRetaining(r->frameChroma, CONSTANTS::RETAINED_DECODE_SAMPLES / static_cast<std::size_t>(r->resolution.hopSize));
+            r->segmentEnds.clear();
+        }
+        dspAllocations = 0;
+        rejectReason = RejectReason::None;
+    }
+
+    FileBuffer file;
+    Mp3Decoder mp3Decoder;
+    WavDecoder wavDecoder;
+    FlacDecoder flacDecoder;
+    AudioDecoder* decoder = &mp3Decoder; // the current track's, see selectDecoder
+    StftProcessor stft;
+    StftProcessor sideStft; // stereo mode only
+    FrameAssembler assembler;
+    // ProcessingOptions::extraResolutions, then the standalone tonal pass if there is one. Every path that frames
+    // the main resolution frames these from the same samples.
+    std::vector<std::unique_ptr<ResolutionContext>> resolutions;
+
+    // The resolution the chroma comes from: at WINDOW_SIZE a bin spans more than a semitone below ~360 Hz, which
+    // leaves out most of the bass and the lower octaves of chords. That is the LONG_WINDOW_SIZE / LONG_HOP_SIZE extra
+    // resolution when there is one, else the pass ProcessingOptions::tonalPass adds; null when there is neither.
+    ResolutionContext* tonal = nullptr;
+
+    // The main resolution's frames.
+    FrameOutputs outputs() { return { &frameFeatures, &frameMfcc, nullptr }; }
+
+    DecodedAudio decoded; // whole-track path only
+    std::vector<Sample> chunk;
+    std::vector<Sample> sideChunk; // sized on first use by stereo mode
+    std::vector<FrameFeatures> frameFeatures;
+    std::vector<FrameMfcc> frameMfcc;
+    std::vector<std::size_t> segmentEnds;
+    std::vector<double> aggregationScratch;
+
+    // operator new calls between decoder open and aggregation, see AllocationCounter.
+    std::uint64_t dspAllocations = 0;
+    // Set when the track is turned away: by the probe before decoding, or by a decode too short to analyze.
+    RejectReason rejectReason = RejectReason::None;
+};
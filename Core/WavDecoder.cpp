@@ -0,0 +1,234 @@
+#include "WavDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "PcmConverter.h"
+
+namespace {
+    constexpr std::uint16_t WAVE_FORMAT_PCM = 0x0001;
+    constexpr std::uint16_t WAVE_FORMAT_IEEE_FLOAT = 0x0003;
+    constexpr std::uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+    std::uint16_t readU16(const std::uint8_t* p) {
+        return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    std::uint32_t readU32(const std::uint8_t* p) {
+        return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8)
+            | (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+    }
+
+    // mid is the mean of all channels, side (L - R) / 2, the same as PcmConverter for 16-bit input.
+    template <typename DecodeSample>
+    void convert(const std::uint8_t* in, std::size_t frames, int channels, int bytesPerSample, int blockAlign,
+        Sample* mid, Sample* side, DecodeSample decodeSample) {
+        const double channelScale = 1.0 / channels;
+
+        for (std::size_t frame = 0; frame < frames; ++frame) {
+            const std::uint8_t* f = in + frame * static_cast<std::size_t>(blockAlign);
+
+            double sum = 0.0;
+            for (int c = 0; c < channels; ++c)
+                sum += decodeSample(f + c * bytesPerSample);
+            mid[frame] = static_cast<Sample>(sum * channelScale);
+
+            if (side)
+                side[frame] = channels > 1
+                    ? static_cast<Sample>((decodeSample(f) - decodeSample(f + bytesPerSample)) * 0.5)
+                    : Sample{ 0 };
+        }
+    }
+}
+
+WavDecoder::~WavDecoder() {
+    close();
+}
+
+// The caller keeps data alive until close().
+bool WavDecoder::open(const std::uint8_t* data, std::size_t size) {
+    close();
+
+    if (!parse(data, size))
+        return false;
+
+    opened = true;
+    return true;
+}
+
+bool WavDecoder::parse(const std::uint8_t* data, std::size_t size) {
+    if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0)
+        return false;
+
+    std::uint16_t formatTag = 0;
+    int bitsPerSample = 0;
+    bool haveFormat = false;
+
+    std::size_t offset = 12;
+    while (offset + 8 <= size) {
+        const std::uint8_t* chunk = data + offset;
+        const std::size_t available = size - offset - 8;
+        const std::size_t chunkSize = readU32(chunk + 4);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || chunkSize > available)
+                return false;
+
+            const std::uint8_t* fmt = chunk + 8;
+            formatTag = readU16(fmt);
+            channels = readU16(fmt + 2);
+            sampleRate = static_cast<int>(readU32(fmt + 4));
+            blockAlign = readU16(fmt + 12);
+            bitsPerSample = readU16(fmt + 14);
+
+            // The real format is the first two bytes of the sub-format GUID.
+            if (formatTag == WAVE_FORMAT_EXTENSIBLE && chunkSize >= 40)
+                formatTag = readU16(fmt + 24);
+
+            haveFormat = true;
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!haveFormat)
+                return false;
+
+            // Streams written before their length was known leave the size at 0 or 0xFFFFFFFF; take what is there.
+            const std::size_t dataSize = (chunkSize == 0 || chunkSize > available) ? available : chunkSize;
+            samples = chunk + 8;
+
+            if (formatTag == WAVE_FORMAT_PCM)
+                encoding = Encoding::Int;
+            else if (formatTag == WAVE_FORMAT_IEEE_FLOAT)
+                encoding = Encoding::Float;
+            else
+                return false;
+
+            if (channels <= 0 || sampleRate <= 0 || blockAlign <= 0 || blockAlign % channels != 0)
+                return false;
+
+            bytesPerSample = blockAlign / channels;
+            const bool supported = encoding == Encoding::Int
+                ? (bytesPerSample >= 1 && bytesPerSample <= 4)
+                : (bytesPerSample == 4 || bytesPerSample == 8);
+
+            if (!supported || bitsPerSample > bytesPerSample * 8)
+                return false;
+
+            totalFrames = dataSize / static_cast<std::size_t>(blockAlign);
+            position = 0;
+            return true;
+        }
+
+        // Chunks are padded to an even length.
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    return false;
+}
+
+std::size_t WavDecoder::readMono(Sample* out, std::size_t maxFrames) {
+    return read(out, nullptr, maxFrames);
+}
+
+std::size_t WavDecoder::readMidSide(Sample* mid, Sample* side, std::size_t maxFrames) {
+    return read(mid, side, maxFrames);
+}
+
+std::size_t WavDecoder::read(Sample* mid, Sample* side, std::size_t maxFrames) {
+    if (!opened || position >= totalFrames)
+        return 0;
+
+    const std::size_t frames = static_cast<std::size_t>(std::min<std::uint64_t>(maxFrames, totalFrames - position));
+    const std::uint8_t* in = samples + position * static_cast<std::uint64_t>(blockAlign);
+    position += frames;
+
+    // The common case goes through the same SIMD converter as MP3 output.
+    if (encoding == Encoding::Int && bytesPerSample == 2 && reinterpret_cast<std::uintptr_t>(in) % alignof(std::int16_t) == 0) {
+        const auto* pcm = reinterpret_cast<const std::int16_t*>(in);
+        if (side)
+            PcmConverter::splitMidSide(pcm, frames, channels, mid, side);
+        else
+            PcmConverter::downmixToMono(pcm, frames, channels, mid);
+        return frames;
+    }
+
+    if (encoding == Encoding::Float) {
+        if (bytesPerSample == 4) {
+            convert(in, frames, channels, bytesPerSample, blockAlign, mid, side, [](const std::uint8_t* p) {
+                float v;
+                std::memcpy(&v, p, sizeof v);
+                return static_cast<double>(v);
+                });
+        }
+        else {
+            convert(in, frames, channels, bytesPerSample, blockAlign, mid, side, [](const std::uint8_t* p) {
+                double v;
+                std::memcpy(&v, p, sizeof v);
+                return v;
+                });
+        }
+        return frames;
+    }
+
+    switch (bytesPerSample) {
+    case 1:
+        // 8-bit WAV is unsigned.
+        convert(in, frames, channels, bytesPerSample, blockAlign, mid, side, [](const std::uint8_t* p) {
+            return (static_cast<int>(p[0]) - 128) / 128.0;
+            });
+        break;
+    case 2:
+        convert(in, frames, channels, bytesPerSample, blockAlign, mid, side, [](const std::uint8_t* p) {
+            return static_cast<std::int16_t>(readU16(p)) / 32768.0;
+            });
+        break;
+    case 3:
+        convert(in, frames, channels, bytesPerSample, blockAlign, mid, side, [](const std::uint8_t* p) {
+            const std::int32_t v = static_cast<std::int32_t>((static_cast<std::uint32_t>(p[0]) << 8)
+                | (static_cast<std::uint32_t>(p[1]) << 16) | (static_cast<std::uint32_t>(p[2]) << 24));
+            return (v >> 8) / 8388608.0;
+            });
+        break;
+    default:
+        convert(in, frames, channels, bytesPerSample, blockAlign, mid, side, [](const std::uint8_t* p) {
+            return static_cast<std::int32_t>(readU32(p)) / 2147483648.0;
+            });
+        break;
+    }
+
+    return frames;
+}
+
+bool WavDecoder::seek(std::uint64_t frame) {
+    if (!opened || frame > totalFrames)
+        return false;
+
+    position = frame;
+    return true;
+}
+
+void WavDecoder::close() {
+    if (!opened)
+        return;
+
+    samples = nullptr;
+    totalFrames = 0;
+    position = 0;
+    opened = false;
+}
+
+// Nothing can fail after open: the data chunk is bounds-checked up front.
+bool WavDecoder::failed() const {
+    return false;
+}
+
+int WavDecoder::getSampleRate() const {
+    return sampleRate;
+}
+
+int WavDecoder::getChannels() const {
+    return channels;
+}
+
+std::uint64_t WavDecoder::getTotalFrames() const {
+    return totalFrames;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "AudioDecoder.h"
+#include "SampleType.h"
+
+/*
+ * RIFF/WAVE reader with no decode step: the data chunk is read in place from the caller's bytes,
+ * converted straight into mono or mid/side samples. Handles integer PCM of 8 to 32 bits and 32/64-bit float,
+ * plain or WAVE_FORMAT_EXTENSIBLE.
+ */
+class WavDecoder : public AudioDecoder {
+public:
+    WavDecoder() = default;
+    ~WavDecoder() override;
+
+    WavDecoder(const WavDecoder&) = delete;
+    WavDecoder& operator=(const WavDecoder&) = delete;
+
+    bool open(const std::uint8_t* data, std::size_t size) override;
+    std::size_t readMono(Sample* out, std::size_t maxFrames) override;
+    std::size_t readMidSide(Sample* mid, Sample* side, std::size_t maxFrames) override;
+    bool seek(std::uint64_t frame) override;
+    void close() override;
+
+    bool failed() const override;
+    int getSampleRate() const override;
+    int getChannels() const override;
+    std::uint64_t getTotalFrames() const override;
+
+private:
+    enum class Encoding { Int, Float };
+
+    bool parse(const std::uint8_t* data, std::size_t size);
+    std::size_t read(Sample* mid, Sample* side, std::size_t maxFrames);
+
+    const std::uint8_t* samples = nullptr;
+    std::uint64_t totalFrames = 0;
+    std::uint64_t position = 0;
+
+    Encoding encoding = Encoding::Int;
+    int sampleRate = 0;
+    int channels = 0;
+    int bytesPerSample = 0;
+    int blockAlign = 0;
+    bool opened = false;
+};
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "SampleType.h"
+
+// Analysis windows for the STFT, all in their symmetric form (w[0] == w[N - 1]).
+enum class WindowFunction {
+    Hann,
+    Hamming,
+    BlackmanHarris, // 4-term, -92 dB sidelobes
+    Kaiser          // beta = KAISER_BETA
+};
+
+inline const char* windowFunctionName(WindowFunction window) {
+    switch (window) {
+    case WindowFunction::Hamming: return "hamming";
+    case WindowFunction::BlackmanHarris: return "blackman-harris";
+    case WindowFunction::Kaiser: return "kaiser";
+    default: return "hann";
+    }
+}
+
+inline std::optional<WindowFunction> windowFunctionFromName(std::string_view name) {
+    for (WindowFunction window : { WindowFunction::Hann, WindowFunction::Hamming, WindowFunction::BlackmanHarris, WindowFunction::Kaiser }) {
+        if (name == windowFunctionName(window))
+            return window;
+    }
+    return std::nullopt;
+}
+
+/*
+ * constexpr replacements for the few <cmath> functions the windows need, so the tables can be built at compile
+ * time. StftProcessor uses the same functions at runtime for the sizes it has no table for, so a window has the
+ * same values either way.
+ */
+namespace WindowMath {
+    constexpr double PI = 3.14159265358979323846;
+    constexpr double KAISER_BETA = 8.6;
+
+    // Taylor series on [0, pi/4], where 10 terms are below double rounding.
+    constexpr double cosNear0(double x) {
+        const double x2 = x * x;
+        double term = 1.0, sum = 1.0;
+        for (int k = 1; k <= 10; ++k) {
+            term *= -x2 / ((2.0 * k - 1.0) * (2.0 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double sinNear0(double x) {
+        const double x2 = x * x;
+        double term = x, sum = x;
+        for (int k = 1; k <= 10; ++k) {
+            term *= -x2 / ((2.0 * k) * (2.0 * k + 1.0));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // x >= 0.
+    constexpr double cos(double x) {
+        const double turns = static_cast<double>(static_cast<long long>(x / (2.0 * PI)));
+        x -= turns * 2.0 * PI;
+        if (x > PI)
+            x = 2.0 * PI - x;
+
+        double sign = 1.0;
+        if (x > PI / 2) {
+            x = PI - x;
+            sign = -1.0;
+        }
+        return sign * (x > PI / 4 ? sinNear0(PI / 2 - x) : cosNear0(x));
+    }
+
+    constexpr double sqrt(double x) {
+        if (x <= 0.0)
+            return 0.0;
+
+        double r = x < 1.0 ? 1.0 : x;
+        for (int i = 0; i < 100; ++i) {
+            const double next = 0.5 * (r + x / r);
+            if (next == r)
+                break;
+            r = next;
+        }
+        return r;
+    }
+
+    // Modified Bessel function of the first kind, order 0.
+    constexpr double besselI0(double x) {
+        const double q = x * x / 4.0;
+        double term = 1.0, sum = 1.0;
+        for (int k = 1; k < 200 && term > sum * 1e-17; ++k) {
+            term *= q / (static_cast<double>(k) * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double window(WindowFunction fn, int n, int size) {
+        const double phase = 2.0 * PI * n / (size - 1);
+
+        switch (fn) {
+        case WindowFunction::Hamming:
+            return 0.54 - 0.46 * cos(phase);
+        case WindowFunction::BlackmanHarris:
+            return 0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2.0 * phase) - 0.01168 * cos(3.0 * phase);
+        case WindowFunction::Kaiser: {
+            const double r = 2.0 * n / (size - 1) - 1.0;
+            return besselI0(KAISER_BETA * sqrt(1.0 - r * r)) / besselI0(KAISER_BETA);
+        }
+        default:
+            return 0.5 * (1.0 - cos(phase));
+        }
+    }
+
+    template <int N, WindowFunction Fn>
+    constexpr std::array<Sample, N> table() {
+        std::array<Sample, N> t{};
+        for (int n = 0; n < N; ++n)
+            t[n] = static_cast<Sample>(window(Fn, n, N));
+        return t;
+    }
+}
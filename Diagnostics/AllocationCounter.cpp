@@ -0,0 +1,71 @@
+#include "AllocationCounter.h"
+
+#ifdef SPECTRAL_AUDIT_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+static thread_local std::uint64_t allocations = 0;
+
+static void* countedAlloc(std::size_t size) {
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+static void* countedAlignedAlloc(std::size_t size, std::align_val_t alignment) {
+    ++allocations;
+    const std::size_t align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+    if (void* p = _aligned_malloc(size ? size : 1, align))
+        return p;
+#else
+    if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return p;
+#endif
+    throw std::bad_alloc();
+}
+
+static void alignedFree(void* p) {
+#ifdef _MSC_VER
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+// The array and nothrow forms forward to these by default.
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return countedAlignedAlloc(size, alignment); }
+void operator delete(void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { alignedFree(p); }
+
+bool AllocationCounter::enabled() {
+    return true;
+}
+
+std::uint64_t AllocationCounter::threadCount() {
+    return allocations;
+}
+
+#else
+
+bool AllocationCounter::enabled() {
+    return false;
+}
+
+std::uint64_t AllocationCounter::threadCount() {
+    return 0;
+}
+
+#endif
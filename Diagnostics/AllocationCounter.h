@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Counts operator new calls per thread when built with SPECTRAL_AUDIT_COUNT_ALLOCATIONS, which replaces the
+ * global allocation functions. Used to check that the worker loop's DSP path stops allocating once warm.
+ * Without the define nothing is replaced and the count stays 0.
+ */
+class AllocationCounter {
+public:
+    static bool enabled();
+    static std::uint64_t threadCount();
+};
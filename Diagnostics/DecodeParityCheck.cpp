@@ -0,0 +1,53 @@
+#include "DecodeParityCheck.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "../Core/AudioDecoder.h"
+#include "../Core/Mp3Decoder.h"
+#include "../Queue/WorkerPool.h"
+#include "../Utilities/FileBuffer.h"
+
+bool DecodeParityCheck::run(const std::filesystem::path& directory, unsigned threads) {
+    namespace fs = std::filesystem;
+
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+        if (entry.is_regular_file() && AudioDecoder::formatFromExtension(entry.path()) == AudioDecoder::Format::Mp3)
+            paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+
+    WorkerPool pool(threads);
+    std::size_t identical = 0, mismatched = 0, skipped = 0;
+
+    for (const auto& path : paths) {
+        FileBuffer file;
+        DecodedAudio parallel, serial;
+        if (!file.open(path)
+            || !Mp3Decoder::decodeReference(file.data(), file.size(), serial)
+            || !Mp3Decoder::decodeParallel(file.data(), file.size(), parallel, pool)) {
+            ++skipped;
+            continue;
+        }
+
+        const std::size_t common = std::min(parallel.samples.size(), serial.samples.size());
+        const auto diff = std::mismatch(parallel.samples.begin(), parallel.samples.begin() + common, serial.samples.begin());
+        const std::size_t firstDifference = static_cast<std::size_t>(diff.first - parallel.samples.begin());
+
+        if (firstDifference == common && parallel.samples.size() == serial.samples.size()
+            && parallel.sampleRate == serial.sampleRate && parallel.channels == serial.channels) {
+            ++identical;
+            continue;
+        }
+
+        ++mismatched;
+        std::wcout << L"MISMATCH " << path.wstring() << L": " << parallel.samples.size() << L" vs " << serial.samples.size()
+            << L" samples, first difference at " << firstDifference << L'\n';
+    }
+
+    std::wcout << paths.size() << L" MP3s, " << threads << L" helpers: " << identical << L" identical, "
+        << mismatched << L" mismatched, " << skipped << L" not decodable\n";
+    return mismatched == 0;
+}
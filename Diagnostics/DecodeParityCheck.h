@@ -0,0 +1,16 @@
+#pragma once
+
+#include <filesystem>
+
+/*
+ * Checks the chunked MP3 decode against the serial one on a real library: every MP3 under the directory is decoded
+ * by Mp3Decoder::decodeParallel on a pool of `threads` helpers and by Mp3Decoder::decodeReference, and the two mono
+ * outputs are compared sample for sample. PARALLEL_DECODE_MIN_BYTES does not apply here: any file with at least
+ * PARALLEL_DECODE_MIN_CHUNK_FRAMES frames per chunk is split. A split that fails its own checks decodes serially,
+ * so a mismatch means the checks let a wrong chunk through.
+ */
+class DecodeParityCheck {
+public:
+    // True when every file decoded identically both ways.
+    static bool run(const std::filesystem::path& directory, unsigned threads);
+};
@@ -0,0 +1,75 @@
+#include "DownmixBenchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../Core/PcmConverter.h"
+
+static constexpr std::size_t FRAMES = 44100 * 60 * 5;
+static constexpr int REPETITIONS = 20;
+
+// The loop decodeMp3Mono used before the kernels existed.
+static void legacyDownmix(const std::int16_t* in, std::size_t frames, int channels, Sample* out) {
+    const std::size_t ch = static_cast<std::size_t>(channels);
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        const std::size_t base = frame * ch;
+        double sum = 0.0;
+        for (std::size_t c = 0; c < ch; ++c)
+            sum += in[base + c];
+        out[frame] = static_cast<Sample>((sum / static_cast<double>(channels)) / 32768.0);
+    }
+}
+
+template <typename Fn>
+static double bestOfMs(Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    double best = 1e300;
+
+    for (int r = 0; r < REPETITIONS; ++r) {
+        const auto t0 = clock::now();
+        fn();
+        const auto t1 = clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return best;
+}
+
+void DownmixBenchmark::run() {
+    using Kernel = PcmConverter::Kernel;
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<int> dist(-32768, 32767);
+
+    std::vector<std::int16_t> pcm(FRAMES * 2);
+    for (auto& s : pcm)
+        s = static_cast<std::int16_t>(dist(rng));
+
+    std::vector<Sample> expected(FRAMES), actual(FRAMES);
+
+    std::wcout << L"Downmix " << FRAMES << L" frames, best of " << REPETITIONS << L" runs\n";
+
+    for (int channels : { 1, 2 }) {
+        const double legacyMs = bestOfMs([&] { legacyDownmix(pcm.data(), FRAMES, channels, expected.data()); });
+
+        std::wcout << L"\n" << (channels == 1 ? L"Mono" : L"Stereo") << L"\n"
+            << std::left << std::setw(10) << L"Legacy" << std::fixed << std::setprecision(3)
+            << legacyMs << L" ms\n";
+
+        for (Kernel kernel : { Kernel::Scalar, Kernel::Sse2, Kernel::Avx2, Kernel::Avx512 }) {
+            if (!PcmConverter::isSupported(kernel))
+                continue;
+
+            const double ms = bestOfMs([&] { PcmConverter::downmixToMono(kernel, pcm.data(), FRAMES, channels, actual.data()); });
+            const bool identical = std::memcmp(expected.data(), actual.data(), FRAMES * sizeof(Sample)) == 0;
+
+            std::wcout << std::left << std::setw(10) << PcmConverter::kernelName(kernel)
+                << ms << L" ms  x" << std::setprecision(2) << legacyMs / ms << std::setprecision(3)
+                << (identical ? L"" : L"  OUTPUT MISMATCH") << L'\n';
+        }
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+/*
+ * Microbenchmark for PcmConverter: times the original per-frame downmix loop against every
+ * kernel the CPU supports on synthetic mono and stereo PCM, and checks that the outputs match.
+ */
+class DownmixBenchmark {
+public:
+    static void run();
+};
@@ -0,0 +1,152 @@
+#include "FeatureCostBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../Core/FeatureExtractor.h"
+#include "../Core/KeyEstimator.h"
+#include "../Core/MelFilterbank.h"
+#include "../Core/PitchClassMap.h"
+#include "../Core/StftProcessor.h"
+#include "../Core/TrackAggregator.h"
+#include "../Resources/Constants.h"
+
+static constexpr int SAMPLE_RATE = 44100;
+static constexpr std::size_t SAMPLES = SAMPLE_RATE * 60;
+static constexpr int REPETITIONS = 5;
+
+// Where the timed loops' outputs end up, so the compiler cannot drop the work that produced them.
+static volatile double sink;
+
+template <typename Fn>
+static double bestOfMs(Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    double best = 1e300;
+
+    for (int r = 0; r < REPETITIONS; ++r) {
+        const auto t0 = clock::now();
+        fn();
+        const auto t1 = clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return best;
+}
+
+// A3, C4 and E4 with a few decaying harmonics each, over a little noise.
+static std::vector<Sample> triad() {
+    constexpr double PI = 3.14159265358979323846;
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> noise(-0.01, 0.01);
+
+    std::vector<Sample> samples(SAMPLES);
+    for (std::size_t i = 0; i < SAMPLES; ++i) {
+        const double t = static_cast<double>(i) / SAMPLE_RATE;
+        double s = noise(rng);
+        for (double f : { 220.0, 261.63, 329.63 }) {
+            for (int h = 1; h <= 4; ++h)
+                s += 0.1 / h * std::sin(2.0 * PI * f * h * t);
+        }
+        samples[i] = static_cast<Sample>(s);
+    }
+    return samples;
+}
+
+// Power spectra of every frame, kept so the feature stages can be timed without the STFT.
+static std::vector<Sample> powerSpectra(StftProcessor& stft, const std::vector<Sample>& samples) {
+    std::vector<Sample> power;
+    stft.forEachFrame(samples.data(), samples.size(), [&](const StftFrame& frame) {
+        power.insert(power.end(), frame.power.begin(), frame.power.end());
+        });
+    return power;
+}
+
+static double stftMs(StftProcessor& stft, const std::vector<Sample>& samples) {
+    return bestOfMs([&] {
+        Sample sum = 0;
+        stft.forEachFrame(samples.data(), samples.size(), [&](const StftFrame& frame) { sum += frame.power[1]; });
+        sink = sum;
+        });
+}
+
+void FeatureCostBenchmark::run() {
+    const std::vector<Sample> samples = triad();
+
+    StftProcessor mainStft(CONSTANTS::WINDOW_SIZE, CONSTANTS::HOP_SIZE, CONSTANTS::STFT_BATCH_FRAMES);
+    StftProcessor tonalStft(CONSTANTS::LONG_WINDOW_SIZE, CONSTANTS::LONG_HOP_SIZE, CONSTANTS::STFT_BATCH_FRAMES);
+    const int mainBins = mainStft.getFrequencyBins();
+    const int tonalBins = tonalStft.getFrequencyBins();
+
+    const std::vector<Sample> mainPower = powerSpectra(mainStft, samples);
+    const std::vector<Sample> tonalPower = powerSpectra(tonalStft, samples);
+    const std::size_t mainFrames = mainPower.size() / mainBins;
+    const std::size_t tonalFrames = tonalPower.size() / tonalBins;
+
+    const double mainStftMs = stftMs(mainStft, samples);
+    const double tonalStftMs = stftMs(tonalStft, samples);
+
+    const FeatureExtractor extractor(SAMPLE_RATE);
+    std::vector<FrameFeatures> features(mainFrames);
+    std::vector<FrameMfcc> mfccs(mainFrames);
+    const double extractMs = bestOfMs([&] {
+        for (std::size_t f = 0; f < mainFrames; ++f) {
+            const std::span<const Sample> power(mainPower.data() + f * mainBins, static_cast<std::size_t>(mainBins));
+            features[f] = extractor.extract(power);
+            extractor.extractMfcc(power, mfccs[f]);
+        }
+        });
+
+    const MelFilterbank& filterbank = MelFilterbank::get(SAMPLE_RATE, mainBins);
+    const double mfccMs = bestOfMs([&] {
+        double mfcc[CONSTANTS::MFCC_COEFFICIENTS], sum = 0.0;
+        for (std::size_t f = 0; f < mainFrames; ++f) {
+            filterbank.mfcc(mainPower.data() + f * mainBins, mfcc);
+            sum += mfcc[1];
+        }
+        sink = sum;
+        });
+
+    const PitchClassMap& pitchClasses = PitchClassMap::get(SAMPLE_RATE, tonalBins);
+    const double chromaMs = bestOfMs([&] {
+        double chroma[CONSTANTS::PITCH_CLASSES], sum = 0.0;
+        for (std::size_t f = 0; f < tonalFrames; ++f) {
+            pitchClasses.chroma(tonalPower.data() + f * tonalBins, chroma);
+            sum += chroma[9];
+        }
+        sink = sum;
+        });
+
+    // Every stage runs once per track, so shares are of the whole per-track cost, not of one resolution's frames.
+    const double totalMs = mainStftMs + extractMs + tonalStftMs + chromaMs;
+    auto report = [&](const std::wstring& stage, double ms, std::size_t frames) {
+        std::wcout << std::left << std::setw(28) << stage << std::right << std::setw(10) << ms << L" ms"
+            << std::setw(10) << ms * 1e6 / frames << L" ns/frame" << std::setw(8) << 100.0 * ms / totalMs << L" %\n";
+        };
+
+    std::wcout << L"One minute at " << SAMPLE_RATE << L" Hz, best of " << REPETITIONS << L" runs; share of the total\n"
+        << std::fixed << std::setprecision(1);
+    auto stftLabel = [](const StftProcessor& stft) {
+        return L"STFT " + std::to_wstring(stft.getWindowSize()) + L"/" + std::to_wstring(stft.getHopSize());
+        };
+    report(stftLabel(mainStft), mainStftMs, mainFrames);
+    report(L"extract + MFCC", extractMs, mainFrames);
+    report(L"  of which MFCC", mfccMs, mainFrames);
+    report(stftLabel(tonalStft) + L" (tonal)", tonalStftMs, tonalFrames);
+    report(L"chroma", chromaMs, tonalFrames);
+    std::wcout << std::left << std::setw(28) << L"total" << std::right << std::setw(10) << totalMs << L" ms\n";
+
+    std::vector<FrameChroma> tonal(tonalFrames);
+    for (std::size_t f = 0; f < tonalFrames; ++f)
+        extractor.extractChroma({ tonalPower.data() + f * tonalBins, static_cast<std::size_t>(tonalBins) }, tonal[f]);
+
+    TrackFeatures track{};
+    TrackAggregator::aggregateTonality(tonal, track);
+    std::wcout << L"Key of the A minor triad: " << KeyEstimator::pitchClassName(track.key.tonic)
+        << (track.key.mode == KeyMode::Minor ? L" minor" : L" major") << L", strength " << std::setprecision(3)
+        << track.key.strength << L'\n';
+}
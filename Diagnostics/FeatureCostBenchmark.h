@@ -0,0 +1,12 @@
+#pragma once
+
+/*
+ * Cost of the spectral features over one minute of audio at the production batch size: the main STFT, the main
+ * resolution's FeatureExtractor::extract with the MFCC stage inside it on its own, and the tonal pass (its own
+ * LONG_WINDOW_SIZE STFT and the chroma). Each is shown as a share of the sum of all four, which is what one track
+ * costs. The synthetic audio is an A minor triad, whose key is printed as a check.
+ */
+class FeatureCostBenchmark {
+public:
+    static void run();
+};
@@ -0,0 +1,85 @@
+#include "FftBatchBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+#include "../Core/StftProcessor.h"
+#include "../Resources/Constants.h"
+
+static constexpr std::size_t SAMPLES = 44100 * 60 * 3;
+static constexpr int REPETITIONS = 5;
+
+template <typename Fn>
+static double bestOfMs(Fn&& fn) {
+    using clock = std::chrono::steady_clock;
+    double best = 1e300;
+
+    for (int r = 0; r < REPETITIONS; ++r) {
+        const auto t0 = clock::now();
+        fn();
+        const auto t1 = clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return best;
+}
+
+// Every frame's spectrum is read, as the feature extractor would, so none of the work can be skipped.
+static double visitAll(StftProcessor& stft, const std::vector<Sample>& samples) {
+    double sum = 0.0;
+    stft.forEachFrame(samples.data(), samples.size(), [&](const StftFrame& frame) {
+        for (Sample p : frame.power)
+            sum += p;
+        });
+    return sum;
+}
+
+void FftBatchBenchmark::run(const std::vector<int>& windowSizes, const std::vector<int>& batchSizes) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> dist(-1.0, 1.0);
+
+    std::vector<Sample> samples(SAMPLES);
+    for (auto& s : samples)
+        s = static_cast<Sample>(dist(rng));
+
+    std::wcout << L"STFT over " << SAMPLES << L" samples, hop = window / 8, best of " << REPETITIONS << L" runs\n";
+
+    for (int windowSize : windowSizes) {
+        const int hopSize = std::max(windowSize / 8, 1);
+
+        // Plans are made in the constructors, so none of the timings include planning.
+        StftProcessor reference(windowSize, hopSize);
+        const SpectrogramMatrix expected = reference.computeMagnitudes(samples);
+        const double referenceMs = bestOfMs([&] { visitAll(reference, samples); });
+
+        std::wcout << L"\nWindow " << windowSize << L", " << expected.frames() << L" frames\n"
+            << std::left << std::setw(10) << L"K = 1" << std::fixed << std::setprecision(3)
+            << referenceMs << L" ms\n";
+
+        for (int batchFrames : batchSizes) {
+            if (batchFrames <= 1)
+                continue;
+
+            StftProcessor batched(windowSize, hopSize, batchFrames);
+            const SpectrogramMatrix actual = batched.computeMagnitudes(samples);
+            const double ms = bestOfMs([&] { visitAll(batched, samples); });
+
+            // Batched plans may pick other codelets, so the spectra agree to rounding rather than bit for bit.
+            double maxDifference = 0.0;
+            for (std::size_t frame = 0; frame < expected.frames(); ++frame) {
+                const auto e = expected.row(frame);
+                const auto a = actual.row(frame);
+                for (std::size_t bin = 0; bin < e.size(); ++bin)
+                    maxDifference = std::max(maxDifference, std::abs(static_cast<double>(e[bin]) - a[bin]));
+            }
+
+            std::wcout << L"K = " << std::setw(6) << batchFrames
+                << ms << L" ms  x" << std::setprecision(2) << referenceMs / ms << std::setprecision(3)
+                << L"  max |diff| " << std::scientific << std::setprecision(1) << maxDifference
+                << std::fixed << std::setprecision(3) << L'\n';
+        }
+    }
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <vector>
+
+/*
+ * Sweep of StftProcessor's batched FFT: times forEachFrame over synthetic audio for every window size and frames-per-batch
+ * pair, against the unbatched processor of the same window size, and reports the largest magnitude difference.
+ */
+class FftBatchBenchmark {
+public:
+    static void run(const std::vector<int>& windowSizes, const std::vector<int>& batchSizes);
+};
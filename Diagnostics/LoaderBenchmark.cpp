@@ -0,0 +1,107 @@
+#include "LoaderBenchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <system_error>
+
+#include "../Core/AudioDecoder.h"
+#include "../Utilities/DiskOrder.h"
+#include "../Utilities/FileLoader.h"
+#include "../Utilities/IoUringFileLoader.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static void dropFromPageCache(const std::vector<std::filesystem::path>& paths) {
+#ifndef _WIN32
+    for (const auto& path : paths) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+#else
+    (void)paths;
+#endif
+}
+
+static void runPass(const wchar_t* label, FileLoader& loader, const std::vector<std::filesystem::path>& paths, const std::vector<std::size_t>& sizes) {
+    using clock = std::chrono::steady_clock;
+
+    dropFromPageCache(paths);
+
+    std::size_t loadedBytes = 0;
+    std::size_t failed = 0;
+    const FileLoader::OnLoaded count = [&](PrefetchedFile&& file) {
+        if (file.bytes.empty())
+            ++failed;
+        loadedBytes += file.bytes.size();
+    };
+
+    const auto t0 = clock::now();
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        PrefetchedFile file;
+        file.path = paths[i];
+        file.bytes.resize(sizes[i]);
+        loader.submit(std::move(file), count);
+    }
+    loader.finish(count);
+    const double seconds = std::chrono::duration<double>(clock::now() - t0).count();
+
+    std::wcout << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(3)
+        << seconds << L" s  " << std::setprecision(1) << std::setw(8) << (loadedBytes / 1048576.0) / seconds << L" MiB/s  "
+        << std::setw(8) << paths.size() / seconds << L" files/s"
+        << (failed ? L"  FAILED: " + std::to_wstring(failed) : L"") << L'\n';
+}
+
+void LoaderBenchmark::run(const std::filesystem::path& directory, const std::vector<unsigned>& queueDepths) {
+    namespace fs = std::filesystem;
+
+    std::vector<fs::path> paths;
+    for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+        if (entry.is_regular_file() && AudioDecoder::isSupportedExtension(entry.path()))
+            paths.push_back(entry.path());
+    }
+    DiskOrder::sort(paths);
+
+    std::vector<std::size_t> sizes;
+    std::size_t totalBytes = 0;
+    for (const auto& path : paths) {
+        std::error_code ec;
+        const auto size = fs::file_size(path, ec);
+        sizes.push_back(ec ? 0 : static_cast<std::size_t>(size));
+        totalBytes += sizes.back();
+    }
+
+    std::wcout << L"Reading " << paths.size() << L" files, " << std::fixed << std::setprecision(1)
+        << totalBytes / 1048576.0 << L" MiB\n";
+
+    BlockingFileLoader blocking;
+    runPass(L"Blocking", blocking, paths, sizes);
+
+#ifdef SPECTRAL_AUDIT_IO_URING
+    bool unregistered = false;
+    for (unsigned depth : queueDepths) {
+        IoUringFileLoader loader(depth);
+        if (!loader.isReady()) {
+            std::wcout << L"io_uring is not available on this kernel\n";
+            return;
+        }
+
+        unregistered |= !loader.usesRegisteredBuffers();
+        const std::wstring label = L"io_uring QD" + std::to_wstring(depth) + (loader.usesRegisteredBuffers() ? L"" : L"*");
+        runPass(label.c_str(), loader, paths, sizes);
+    }
+
+    if (unregistered)
+        std::wcout << L"* slots could not be registered, plain READ was used\n";
+#else
+    (void)queueDepths;
+    std::wcout << L"io_uring is not compiled into this build\n";
+#endif
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+/*
+ * Compares the read-ahead backends on a real library: every MP3 under the directory is read in on-disk order
+ * by the blocking loader and by io_uring at each queue depth. On POSIX the files are dropped from the page cache
+ * before every pass (POSIX_FADV_DONTNEED), so the timings are cold reads; on Windows the cache is left warm.
+ */
+class LoaderBenchmark {
+public:
+    static void run(const std::filesystem::path& directory, const std::vector<unsigned>& queueDepths);
+};
@@ -0,0 +1,147 @@
+#include "PrecisionReport.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sqlite3.h>
+#include <stdexcept>
+#include <vector>
+
+static constexpr double ABS_FLOOR = 1e-9;
+
+namespace {
+    struct ColumnDrift {
+        std::string name;
+        std::size_t compared = 0;
+        double maxAbs = 0.0;
+        double maxRel = 0.0;
+        double sumRel = 0.0;
+        std::string worstPath;
+    };
+}
+
+static std::vector<std::string> featureColumns(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "PRAGMA main.table_info(track_features);", -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    std::vector<std::string> columns;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const std::string name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        if (name != "track_id")
+            columns.push_back(name);
+    }
+
+    sqlite3_finalize(stmt);
+    return columns;
+}
+
+static std::wstring widen(const std::string& utf8) {
+    return std::filesystem::path(std::u8string(utf8.begin(), utf8.end())).wstring();
+}
+
+bool PrecisionReport::run(const std::string& referenceDbPath, const std::string& candidateDbPath, double relTolerance) {
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(referenceDbPath.c_str(), &db, SQLITE_OPEN_READONLY, nullptr) != SQLITE_OK) {
+        sqlite3_close(db);
+        throw std::runtime_error("Failed to open reference database");
+    }
+
+    sqlite3_stmt* attach = nullptr;
+    sqlite3_prepare_v2(db, "ATTACH DATABASE ? AS candidate;", -1, &attach, nullptr);
+    sqlite3_bind_text(attach, 1, candidateDbPath.c_str(), -1, SQLITE_TRANSIENT);
+    const int attached = sqlite3_step(attach);
+    sqlite3_finalize(attach);
+
+    if (attached != SQLITE_DONE) {
+        const std::string msg = sqlite3_errmsg(db);
+        sqlite3_close(db);
+        throw std::runtime_error(msg);
+    }
+
+    std::vector<ColumnDrift> drift;
+    for (const auto& column : featureColumns(db)) {
+        ColumnDrift d;
+        d.name = column;
+        drift.push_back(d);
+    }
+
+    std::string sql = "SELECT r.path";
+    for (const auto& d : drift)
+        sql += ", rf." + d.name + ", cf." + d.name;
+    sql += R"sql(
+        FROM main.tracks r
+        JOIN main.track_features rf ON rf.track_id = r.id
+        JOIN candidate.tracks c ON c.path = r.path
+        JOIN candidate.track_features cf ON cf.track_id = c.id;
+    )sql";
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        const std::string msg = sqlite3_errmsg(db);
+        sqlite3_close(db);
+        throw std::runtime_error(msg);
+    }
+
+    std::size_t tracks = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ++tracks;
+        const std::string path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+
+        for (std::size_t c = 0; c < drift.size(); ++c) {
+            const int refCol = static_cast<int>(1 + 2 * c);
+            if (sqlite3_column_type(stmt, refCol) == SQLITE_NULL || sqlite3_column_type(stmt, refCol + 1) == SQLITE_NULL)
+                continue;
+
+            const double reference = sqlite3_column_double(stmt, refCol);
+            const double candidate = sqlite3_column_double(stmt, refCol + 1);
+
+            const double absDiff = std::abs(reference - candidate);
+            const double relDiff = absDiff / std::max({ std::abs(reference), std::abs(candidate), ABS_FLOOR });
+
+            ColumnDrift& d = drift[c];
+            ++d.compared;
+            d.maxAbs = std::max(d.maxAbs, absDiff);
+            d.sumRel += relDiff;
+
+            if (relDiff > d.maxRel) {
+                d.maxRel = relDiff;
+                d.worstPath = path;
+            }
+        }
+    }
+
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    std::size_t failing = 0;
+
+    std::wcout << std::left << std::setw(34) << L"column"
+        << std::setw(14) << L"max abs" << std::setw(14) << L"max rel" << std::setw(14) << L"mean rel" << L"status\n";
+
+    for (const auto& d : drift) {
+        const bool ok = d.maxRel <= relTolerance;
+        if (!ok)
+            ++failing;
+
+        std::wcout << std::left << std::setw(34) << widen(d.name)
+            << std::scientific << std::setprecision(3)
+            << std::setw(14) << d.maxAbs
+            << std::setw(14) << d.maxRel
+            << std::setw(14) << (d.compared ? d.sumRel / d.compared : 0.0)
+            << (ok ? L"ok" : L"DRIFT");
+
+        if (!ok)
+            std::wcout << L"  worst: " << widen(d.worstPath);
+
+        std::wcout << L'\n';
+    }
+
+    std::wcout << std::defaultfloat
+        << L"Tracks compared: " << tracks
+        << L", columns over tolerance (" << relTolerance << L"): " << failing << L'/' << drift.size() << L'\n';
+
+    return tracks > 0 && failing == 0;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+
+/*
+ * Tolerance report for the SPECTRAL_AUDIT_FLOAT32 build.
+ * Run the double and the float build over the same reference corpus into two databases, then compare
+ * every track_features column track by track (matched on path).
+ */
+class PrecisionReport {
+public:
+    static bool run(const std::string& referenceDbPath, const std::string& candidateDbPath, double relTolerance);
+};
@@ -1,25 +1,124 @@
 ﻿#define NOMINMAX
 
 #include <iostream>
+#include <string>
 
+#include "Core/FftPlanner.h"
 #include "Utilities/BlackMetalSanitizer.h"
 #include "Resources/Constants.h"
 #include "TrackBatchProcessor.h"
 #include "Persistence/SqliteTrackSink.h"
 #include "Persistence/TrackSink.h"
+#include "Diagnostics/DecodeParityCheck.h"
+#include "Diagnostics/DownmixBenchmark.h"
+#include "Diagnostics/FeatureCostBenchmark.h"
+#include "Diagnostics/FftBatchBenchmark.h"
+#include "Diagnostics/LoaderBenchmark.h"
+#include "Diagnostics/PrecisionReport.h"
 
 static void printDuration(std::chrono::milliseconds ms);
 
-int main() {
+int main(int argc, char* argv[]) {
     BlackMetalSanitizer::setupConsole();
 
+    const std::string mode = argc > 1 ? argv[1] : "";
+
+    // SpectralAudit --compare-db <reference.db> <candidate.db> [relative tolerance]
+    if (mode == "--compare-db" && argc >= 4) {
+        const double tolerance = argc >= 5 ? std::stod(argv[4]) : 1e-3;
+        return PrecisionReport::run(argv[2], argv[3], tolerance) ? 0 : 1;
+    }
+
+    // SpectralAudit --check-parallel-decode <directory> [helper threads]
+    if (mode == "--check-parallel-decode" && argc >= 3) {
+        const unsigned threads = argc >= 4 ? static_cast<unsigned>(std::stoul(argv[3])) : CONSTANTS::PARALLEL_DECODE_THREADS;
+        return DecodeParityCheck::run(argv[2], threads) ? 0 : 1;
+    }
+
+    if (mode == "--bench-downmix") {
+        DownmixBenchmark::run();
+        return 0;
+    }
+
+    // SpectralAudit --bench-features: per-frame cost of the STFT and the feature stages.
+    if (mode == "--bench-features") {
+        FftPlanner::loadWisdom(CONSTANTS::FFTW_WISDOM_PATH);
+        FeatureCostBenchmark::run();
+        FftPlanner::saveWisdom(CONSTANTS::FFTW_WISDOM_PATH);
+        return 0;
+    }
+
+    // SpectralAudit --bench-fft [frames per batch...]
+    if (mode == "--bench-fft") {
+        std::vector<int> batchSizes;
+        for (int i = 2; i < argc; ++i)
+            batchSizes.push_back(std::stoi(argv[i]));
+        if (batchSizes.empty())
+            batchSizes = { 2, 4, 8, 16, 32, 64 };
+
+        FftPlanner::loadWisdom(CONSTANTS::FFTW_WISDOM_PATH);
+        FftBatchBenchmark::run({ 1024, CONSTANTS::WINDOW_SIZE, 4096, 8192 }, batchSizes);
+        FftPlanner::saveWisdom(CONSTANTS::FFTW_WISDOM_PATH);
+        return 0;
+    }
+
+    // SpectralAudit --bench-loader <directory> [queue depth...]
+    if (mode == "--bench-loader" && argc >= 3) {
+        std::vector<unsigned> depths;
+        for (int i = 3; i < argc; ++i)
+            depths.push_back(static_cast<unsigned>(std::stoul(argv[i])));
+        if (depths.empty())
+            depths = { 1, 4, 16, 64 };
+
+        LoaderBenchmark::run(argv[2], depths);
+        return 0;
+    }
+
     using clock = std::chrono::steady_clock;
     const auto t0 = clock::now();
 
+    // SpectralAudit [--survey] [--stereo] [--pcm-cache] [--fftw-patient] [--multi-resolution] [--tonal] [--window=<name>] [--parallel-decode]
+    // --survey: sampled segments only, upgraded by the next full run. --stereo: adds mid/side features.
+    // --pcm-cache: reuse (and fill) the decoded-PCM cache, for re-analysis runs.
+    // --fftw-patient: plan with FFTW_PATIENT instead of FFTW_MEASURE; the result is kept in the wisdom file.
+    // --multi-resolution: also analyze short and long windows, stored per resolution in track_resolution_features.
+    // --tonal: chroma and key from a long-window pass of their own; --multi-resolution gives them without one.
+    // --window=hann|hamming|blackman-harris|kaiser: the STFT analysis window, hann by default.
+    // --parallel-decode: decode long MP3s whole, in chunks on the frame pool, instead of streaming them.
+    ProcessingOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string flag = argv[i];
+        options.survey |= flag == "--survey";
+        options.stereo |= flag == "--stereo";
+        options.parallelDecode |= flag == "--parallel-decode";
+        options.tonalPass |= flag == "--tonal";
+
+        if (flag == "--pcm-cache")
+            options.pcmCacheDirectory = CONSTANTS::PCM_CACHE_DIRECTORY;
+        if (flag == "--fftw-patient")
+            FftPlanner::setPlannerFlags(FFTW_PATIENT);
+        if (flag.rfind("--window=", 0) == 0) {
+            const auto window = windowFunctionFromName(flag.substr(9));
+            if (!window) {
+                std::cerr << "Unknown window: " << flag.substr(9) << '\n';
+                return 1;
+            }
+            options.window = *window;
+        }
+        if (flag == "--multi-resolution")
+            options.extraResolutions = {
+                { CONSTANTS::SHORT_WINDOW_SIZE, CONSTANTS::SHORT_HOP_SIZE },
+                { CONSTANTS::LONG_WINDOW_SIZE, CONSTANTS::LONG_HOP_SIZE } };
+    }
+
+    // Measured plans cost seconds to make; the wisdom file makes that a one-off per machine.
+    FftPlanner::loadWisdom(CONSTANTS::FFTW_WISDOM_PATH);
+
     SqliteTrackSink dbSink(CONSTANTS::DB_PATH_V5);
-    TrackBatchProcessor batchProcessor(CONSTANTS::INPUT_DIRECTORY, dbSink);
+    TrackBatchProcessor batchProcessor(CONSTANTS::INPUT_DIRECTORY, dbSink, options);
 
-    batchProcessor.runParallel(13, 32);
+    batchProcessor.runParallel(13, CONSTANTS::READ_AHEAD_BYTES);
+    FftPlanner::saveWisdom(CONSTANTS::FFTW_WISDOM_PATH);
 
     const auto t1 = clock::now();
 
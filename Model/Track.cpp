@@ -7,6 +7,10 @@ void Track::setTrackFeatures(TrackFeatures features) {
     this->trackFeatures = features;
 }
 
+void Track::addResolutionFeatures(ResolutionFeatures features) {
+    this->resolutionFeatures.push_back(std::move(features));
+}
+
 const TrackMetadata& Track::getMetadata() const {
     return this->metadata;
 }
@@ -14,3 +18,7 @@ const TrackMetadata& Track::getMetadata() const {
 const TrackFeatures& Track::getTrackFeatures() const {
     return this->trackFeatures;
 }
+
+const std::vector<ResolutionFeatures>& Track::getResolutionFeatures() const {
+    return this->resolutionFeatures;
+}
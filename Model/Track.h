@@ -9,11 +9,15 @@ public:
     explicit Track(TrackMetadata metadata);
 
     void setTrackFeatures(TrackFeatures features);
+    void addResolutionFeatures(ResolutionFeatures features);
 
     const TrackMetadata& getMetadata() const;
     const TrackFeatures& getTrackFeatures() const;
+    // Extra resolutions only; getTrackFeatures() is the main one.
+    const std::vector<ResolutionFeatures>& getResolutionFeatures() const;
 
 private:
     TrackMetadata metadata;
     TrackFeatures trackFeatures;
+    std::vector<ResolutionFeatures> resolutionFeatures;
 };
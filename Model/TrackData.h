@@ -1,7 +1,11 @@
 #pragma once
+#include <array>
 #include <filesystem>
 #include <string>
 
+#include "../Core/WindowFunction.h"
+#include "../Resources/Constants.h"
+
 struct FrameFeatures {
     double pcmRms; // time-domain RMS
     double peak;
@@ -11,8 +15,20 @@ struct FrameFeatures {
     double spectralRolloff85;
     double spectralFlatness;
     double hfRatio;
+
+    // Stereo mode only, 0 otherwise.
+    double interChannelCorrelation; // time-domain L/R correlation, 1 for mono content
+    double stereoWidth; // energy-weighted mean over bins of |S| / (|M| + |S|)
+    double sideEnergyRatio; // side energy / (mid + side energy)
 };
 
+// The MFCCs of one main-resolution frame, see MelFilterbank. Kept beside FrameFeatures, not in it, so the frames of
+// the extra resolutions do not carry them.
+using FrameMfcc = std::array<double, CONSTANTS::MFCC_COEFFICIENTS>;
+
+// Energy share per pitch class of one LONG_WINDOW_SIZE frame, 0 = C, see PitchClassMap.
+using FrameChroma = std::array<double, CONSTANTS::PITCH_CLASSES>;
+
 struct FeatureStats {
     double mean;
     double median;
@@ -22,6 +38,19 @@ struct FeatureStats {
     double p95;
     double min;
     double max;
+
+    double samplingError; // standard error of the mean when only segments were analyzed, 0 otherwise
+};
+
+enum class KeyMode {
+    Major,
+    Minor
+};
+
+struct KeyEstimate {
+    int tonic = -1; // pitch class, 0 = C; -1 when no frame had energy in the chroma range
+    KeyMode mode = KeyMode::Major;
+    double strength = 0.0; // correlation of the track chroma with the key's profile, see KeyEstimator
 };
 
 struct TrackFeatures {
@@ -32,6 +61,37 @@ struct TrackFeatures {
     FeatureStats spectralRolloff85;
     FeatureStats spectralFlatness;
     FeatureStats hfRatio;
+
+    bool hasStereo = false;
+    FeatureStats interChannelCorrelation;
+    FeatureStats stereoWidth;
+    FeatureStats sideEnergyRatio;
+
+    FeatureStats mfcc[CONSTANTS::MFCC_COEFFICIENTS];
+
+    // Only when the track had a LONG_WINDOW_SIZE pass, see TrackContext::tonal.
+    bool hasTonality = false;
+    double chroma[CONSTANTS::PITCH_CLASSES]; // mean of the LONG_WINDOW_SIZE frames' chroma vectors
+    KeyEstimate key;
+};
+
+// Window and hop of one STFT pass, in samples.
+struct StftResolution {
+    int windowSize = 0;
+    int hopSize = 0;
+};
+
+// The mono features of one extra STFT resolution run over the same decoded samples as the main one.
+// Stereo features are only computed at the main resolution, so hasStereo is always false here.
+struct ResolutionFeatures {
+    StftResolution resolution;
+    size_t frameCount = 0;
+    TrackFeatures features;
+};
+
+enum class AnalysisMode {
+    Full,
+    Survey // evenly spaced segments only, see ProcessingOptions::survey
 };
 
 struct TrackMetadata {
@@ -46,4 +106,34 @@ struct TrackMetadata {
 
     size_t totalSamples;
     size_t frameCount;
+
+    AnalysisMode analysisMode = AnalysisMode::Full;
+    WindowFunction window = WindowFunction::Hann; // of every STFT resolution the features came from
+};
+
+// Why a file was turned away by the pre-decode probe; see Mp3Decoder::probe.
+enum class RejectReason {
+    None,
+    Unreadable,   // could not be opened or read
+    Empty,        // nothing but tags
+    NoSync,       // no run of valid MPEG frame headers near the start
+    FormatChange, // channel count changes between the first frames
+    TooShort      // estimated or decoded duration below one analysis window
+};
+
+// Stable codes for the log and the rejected_tracks table.
+inline const char* rejectReasonCode(RejectReason reason) {
+    switch (reason) {
+    case RejectReason::Unreadable: return "unreadable";
+    case RejectReason::Empty: return "empty";
+    case RejectReason::NoSync: return "no_sync";
+    case RejectReason::FormatChange: return "format_change";
+    case RejectReason::TooShort: return "too_short";
+    default: return "none";
+    }
+}
+
+struct TrackRejection {
+    std::filesystem::path path;
+    RejectReason reason = RejectReason::None;
 };
\ No newline at end of file
@@ -1,10 +1,59 @@
 #include "SqliteDatabase.h"
 
+#include <iterator>
 #include <stdexcept>
 #include <string>
 
+#include "../Core/KeyEstimator.h"
+#include "../Resources/Constants.h"
 #include "../Utilities/BlackMetalSanitizer.h"
 
+static const char* toString(AnalysisMode mode) {
+    return mode == AnalysisMode::Survey ? "survey" : "full";
+}
+
+// Column prefixes of the mono features and the statistics stored for each, in binding order.
+static constexpr const char* MONO_FEATURES[] = {
+    "pcm_rms", "peak", "spectral_rms", "spectral_centroid", "spectral_rolloff85", "spectral_flatness", "hf_ratio" };
+static constexpr const char* FEATURE_STATS[] = {
+    "mean", "median", "stddev", "p05", "p50", "p95", "min", "max", "sampling_error" };
+
+static std::string resolutionColumns(const char* type) {
+    std::string columns;
+    for (const char* feature : MONO_FEATURES) {
+        for (const char* stat : FEATURE_STATS) {
+            columns += columns.empty() ? "" : ", ";
+            columns += std::string(feature) + "_" + stat + type;
+        }
+    }
+    return columns;
+}
+
+// track_tonality's chroma columns, C first; "s" marks a sharp.
+static constexpr const char* CHROMA_COLUMNS[CONSTANTS::PITCH_CLASSES] = {
+    "chroma_c", "chroma_cs", "chroma_d", "chroma_ds", "chroma_e", "chroma_f",
+    "chroma_fs", "chroma_g", "chroma_gs", "chroma_a", "chroma_as", "chroma_b" };
+
+static std::string chromaColumns(const char* type) {
+    std::string columns;
+    for (const char* column : CHROMA_COLUMNS) {
+        columns += columns.empty() ? "" : ", ";
+        columns += std::string(column) + type;
+    }
+    return columns;
+}
+
+// mfcc_1 .. mfcc_N, each with every statistic; too many to spell out in the schema.
+static std::string mfccColumns(const char* type) {
+    std::string columns;
+    for (int k = 1; k <= CONSTANTS::MFCC_COEFFICIENTS; ++k) {
+        for (const char* stat : FEATURE_STATS) {
+            columns += columns.empty() ? "" : ", ";
+            columns += "mfcc_" + std::to_string(k) + "_" + stat + type;
+        }
+    }
+    return columns;
+}
 
 static void exec(sqlite3* db, const char* sql) {
     char* err = nullptr;
@@ -24,14 +73,29 @@ SqliteDatabase::SqliteDatabase(const std::string& dbPath) {
     exec(db, "PRAGMA foreign_keys = ON;");
 
     if (sqlite3_prepare_v2(db,
-        "INSERT OR IGNORE INTO tracks "
-        "(path, title, artist, album, year, duration_seconds, sample_rate, total_samples, frame_count) "
-        "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);",
+        R"sql(
+        INSERT INTO tracks
+            (path, title, artist, album, year, duration_seconds, sample_rate, total_samples, frame_count, analysis_mode, window_function)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+        ON CONFLICT(path) DO UPDATE SET
+            title = excluded.title,
+            artist = excluded.artist,
+            album = excluded.album,
+            year = excluded.year,
+            duration_seconds = excluded.duration_seconds,
+            sample_rate = excluded.sample_rate,
+            total_samples = excluded.total_samples,
+            frame_count = excluded.frame_count,
+            analysis_mode = excluded.analysis_mode,
+            window_function = excluded.window_function
+        WHERE tracks.analysis_mode = 'survey' OR excluded.analysis_mode = 'full'
+        RETURNING id;
+        )sql",
         -1, &insertTrackStmt, nullptr) != SQLITE_OK)
         throw std::runtime_error(sqlite3_errmsg(db));
 
-    if (sqlite3_prepare_v2(db,
-        R"sql(
+    // The MFCC columns close both lists.
+    std::string insertFeatures = R"sql(
         INSERT OR REPLACE INTO track_features (
             track_id,
             pcm_rms_mean, pcm_rms_median, pcm_rms_stddev,
@@ -57,7 +121,25 @@ SqliteDatabase::SqliteDatabase(const std::string& dbPath) {
             spectral_flatness_min, spectral_flatness_max,
             hf_ratio_mean, hf_ratio_median, hf_ratio_stddev,
             hf_ratio_p05, hf_ratio_p50, hf_ratio_p95,
-            hf_ratio_min, hf_ratio_max
+            hf_ratio_min, hf_ratio_max,
+            pcm_rms_sampling_error, peak_sampling_error,
+            spectral_rms_sampling_error, spectral_centroid_sampling_error,
+            spectral_rolloff85_sampling_error, spectral_flatness_sampling_error,
+            hf_ratio_sampling_error,
+            inter_channel_correlation_mean, inter_channel_correlation_median,
+            inter_channel_correlation_stddev, inter_channel_correlation_p05,
+            inter_channel_correlation_p50, inter_channel_correlation_p95,
+            inter_channel_correlation_min, inter_channel_correlation_max,
+            stereo_width_mean, stereo_width_median, stereo_width_stddev,
+            stereo_width_p05, stereo_width_p50, stereo_width_p95,
+            stereo_width_min, stereo_width_max,
+            side_energy_ratio_mean, side_energy_ratio_median,
+            side_energy_ratio_stddev, side_energy_ratio_p05,
+            side_energy_ratio_p50, side_energy_ratio_p95,
+            side_energy_ratio_min, side_energy_ratio_max,
+            inter_channel_correlation_sampling_error, stereo_width_sampling_error,
+            side_energy_ratio_sampling_error, )sql"
+        + mfccColumns("") + R"sql(
         ) VALUES (?,
             ?,?,?,?,?,?,?,?,
             ?,?,?,?,?,?,?,?,
@@ -65,10 +147,54 @@ SqliteDatabase::SqliteDatabase(const std::string& dbPath) {
             ?,?,?,?,?,?,?,?,
             ?,?,?,?,?,?,?,?,
             ?,?,?,?,?,?,?,?,
-            ?,?,?,?,?,?,?,?
-        );
+            ?,?,?,?,?,?,?,?,
+            ?,?,?,?,?,?,?,
+            ?,?,?,?,?,?,?,?,
+            ?,?,?,?,?,?,?,?,
+            ?,?,?,?,?,?,?,?,
+            ?,?,?)sql";
+    for (std::size_t c = 0; c < CONSTANTS::MFCC_COEFFICIENTS * std::size(FEATURE_STATS); ++c)
+        insertFeatures += ", ?";
+    insertFeatures += ");";
+
+    if (sqlite3_prepare_v2(db, insertFeatures.c_str(), -1, &insertFeaturesStmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    if (sqlite3_prepare_v2(db,
+        R"sql(
+        INSERT INTO rejected_tracks (path, reason)
+        VALUES (?, ?)
+        ON CONFLICT(path) DO UPDATE SET reason = excluded.reason;
         )sql",
-        -1, &insertFeaturesStmt, nullptr) != SQLITE_OK)
+        -1, &insertRejectionStmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    if (sqlite3_prepare_v2(db, "DELETE FROM rejected_tracks WHERE path = ?;", -1, &clearRejectionStmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    std::string insertResolution =
+        "INSERT OR REPLACE INTO track_resolution_features (track_id, window_size, hop_size, frame_count, "
+        + resolutionColumns("") + ") VALUES (?, ?, ?, ?";
+    for (std::size_t c = 0; c < std::size(MONO_FEATURES) * std::size(FEATURE_STATS); ++c)
+        insertResolution += ", ?";
+    insertResolution += ");";
+
+    if (sqlite3_prepare_v2(db, insertResolution.c_str(), -1, &insertResolutionStmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    if (sqlite3_prepare_v2(db, "DELETE FROM track_resolution_features WHERE track_id = ?;", -1, &clearResolutionsStmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    std::string insertTonality =
+        "INSERT OR REPLACE INTO track_tonality (track_id, key_tonic, key_mode, key_strength, " + chromaColumns("") + ") VALUES (?, ?, ?, ?";
+    for (std::size_t c = 0; c < std::size(CHROMA_COLUMNS); ++c)
+        insertTonality += ", ?";
+    insertTonality += ");";
+
+    if (sqlite3_prepare_v2(db, insertTonality.c_str(), -1, &insertTonalityStmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    if (sqlite3_prepare_v2(db, "DELETE FROM track_tonality WHERE track_id = ?;", -1, &clearTonalityStmt, nullptr) != SQLITE_OK)
         throw std::runtime_error(sqlite3_errmsg(db));
 }
 
@@ -78,6 +204,18 @@ SqliteDatabase::~SqliteDatabase() {
         sqlite3_finalize(insertTrackStmt);
     if (insertFeaturesStmt) 
         sqlite3_finalize(insertFeaturesStmt);
+    if (insertRejectionStmt)
+        sqlite3_finalize(insertRejectionStmt);
+    if (clearRejectionStmt)
+        sqlite3_finalize(clearRejectionStmt);
+    if (insertResolutionStmt)
+        sqlite3_finalize(insertResolutionStmt);
+    if (clearResolutionsStmt)
+        sqlite3_finalize(clearResolutionsStmt);
+    if (insertTonalityStmt)
+        sqlite3_finalize(insertTonalityStmt);
+    if (clearTonalityStmt)
+        sqlite3_finalize(clearTonalityStmt);
     if (db) 
         sqlite3_close(db);
 }
@@ -112,14 +250,28 @@ void SqliteDatabase::insertTrack(const Track& track) {
     sqlite3_bind_int(insertTrackStmt, 7, metadata.sampleRate);
     sqlite3_bind_int64(insertTrackStmt, 8, metadata.totalSamples);
     sqlite3_bind_int64(insertTrackStmt, 9, metadata.frameCount);
+    sqlite3_bind_text(insertTrackStmt, 10, toString(metadata.analysisMode), -1, SQLITE_STATIC);
+    sqlite3_bind_text(insertTrackStmt, 11, windowFunctionName(metadata.window), -1, SQLITE_STATIC);
 
-    if (sqlite3_step(insertTrackStmt) != SQLITE_DONE)
+    // No row comes back when the upsert is skipped: a survey never overwrites a full analysis.
+    const int rc = sqlite3_step(insertTrackStmt);
+    if (rc != SQLITE_ROW && rc != SQLITE_DONE)
         throw std::runtime_error(sqlite3_errmsg(db));
 
+    const sqlite3_int64 trackId = rc == SQLITE_ROW ? sqlite3_column_int64(insertTrackStmt, 0) : 0;
+
     sqlite3_reset(insertTrackStmt);
     sqlite3_clear_bindings(insertTrackStmt);
 
-    const sqlite3_int64 trackId = sqlite3_last_insert_rowid(db);
+    if (rc != SQLITE_ROW)
+        return;
+
+    // A file that decodes now is no longer rejected.
+    sqlite3_bind_text(clearRejectionStmt, 1, storedPath.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(clearRejectionStmt) != SQLITE_DONE)
+        throw std::runtime_error(sqlite3_errmsg(db));
+    sqlite3_reset(clearRejectionStmt);
+    sqlite3_clear_bindings(clearRejectionStmt);
 
     int i = 1;
     sqlite3_bind_int64(insertFeaturesStmt, i++, trackId);
@@ -142,13 +294,123 @@ void SqliteDatabase::insertTrack(const Track& track) {
         BIND_STATS(features.spectralFlatness)
         BIND_STATS(features.hfRatio)
 
+    sqlite3_bind_double(insertFeaturesStmt, i++, features.pcmRms.samplingError);
+    sqlite3_bind_double(insertFeaturesStmt, i++, features.peak.samplingError);
+    sqlite3_bind_double(insertFeaturesStmt, i++, features.spectralRms.samplingError);
+    sqlite3_bind_double(insertFeaturesStmt, i++, features.spectralCentroid.samplingError);
+    sqlite3_bind_double(insertFeaturesStmt, i++, features.spectralRolloff85.samplingError);
+    sqlite3_bind_double(insertFeaturesStmt, i++, features.spectralFlatness.samplingError);
+    sqlite3_bind_double(insertFeaturesStmt, i++, features.hfRatio.samplingError);
+
+    // Left NULL (cleared bindings) for tracks analyzed without stereo mode.
+    if (features.hasStereo) {
+        BIND_STATS(features.interChannelCorrelation)
+            BIND_STATS(features.stereoWidth)
+            BIND_STATS(features.sideEnergyRatio)
+
+        sqlite3_bind_double(insertFeaturesStmt, i++, features.interChannelCorrelation.samplingError);
+        sqlite3_bind_double(insertFeaturesStmt, i++, features.stereoWidth.samplingError);
+        sqlite3_bind_double(insertFeaturesStmt, i++, features.sideEnergyRatio.samplingError);
+    }
+
 #undef BIND_STATS
 
+    // The last parameters, in mfccColumns() order; counted from the end since the stereo ones may be skipped above.
+    i = sqlite3_bind_parameter_count(insertFeaturesStmt) - static_cast<int>(std::size(features.mfcc) * std::size(FEATURE_STATS)) + 1;
+    for (const FeatureStats& s : features.mfcc) {
+        for (double value : { s.mean, s.median, s.stddev, s.p05, s.p50, s.p95, s.min, s.max, s.samplingError })
+            sqlite3_bind_double(insertFeaturesStmt, i++, value);
+    }
+
         if (sqlite3_step(insertFeaturesStmt) != SQLITE_DONE)
             throw std::runtime_error(sqlite3_errmsg(db));
 
     sqlite3_reset(insertFeaturesStmt);
     sqlite3_clear_bindings(insertFeaturesStmt);
+
+    // Without a tonal pass this run, a row from an earlier one would outlive the features it was computed with.
+    if (features.hasTonality) {
+        insertTonality(trackId, features);
+    }
+    else {
+        sqlite3_bind_int64(clearTonalityStmt, 1, trackId);
+        if (sqlite3_step(clearTonalityStmt) != SQLITE_DONE)
+            throw std::runtime_error(sqlite3_errmsg(db));
+        sqlite3_reset(clearTonalityStmt);
+        sqlite3_clear_bindings(clearTonalityStmt);
+    }
+
+    // Resolutions an earlier run stored but this one did not analyze (e.g. a run without --multi-resolution) would
+    // otherwise outlive the features they were computed with.
+    sqlite3_bind_int64(clearResolutionsStmt, 1, trackId);
+    if (sqlite3_step(clearResolutionsStmt) != SQLITE_DONE)
+        throw std::runtime_error(sqlite3_errmsg(db));
+    sqlite3_reset(clearResolutionsStmt);
+    sqlite3_clear_bindings(clearResolutionsStmt);
+
+    for (const ResolutionFeatures& block : track.getResolutionFeatures())
+        insertResolutionFeatures(trackId, block);
+}
+
+void SqliteDatabase::insertTonality(sqlite3_int64 trackId, const TrackFeatures& features) {
+    int i = 1;
+    sqlite3_bind_int64(insertTonalityStmt, i++, trackId);
+
+    // The key is left NULL when the chroma range held no energy.
+    if (features.key.tonic >= 0) {
+        sqlite3_bind_text(insertTonalityStmt, i++, KeyEstimator::pitchClassName(features.key.tonic), -1, SQLITE_STATIC);
+        sqlite3_bind_text(insertTonalityStmt, i++, features.key.mode == KeyMode::Minor ? "minor" : "major", -1, SQLITE_STATIC);
+        sqlite3_bind_double(insertTonalityStmt, i++, features.key.strength);
+    }
+    else {
+        i += 3;
+    }
+
+    for (double value : features.chroma)
+        sqlite3_bind_double(insertTonalityStmt, i++, value);
+
+    if (sqlite3_step(insertTonalityStmt) != SQLITE_DONE)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    sqlite3_reset(insertTonalityStmt);
+    sqlite3_clear_bindings(insertTonalityStmt);
+}
+
+void SqliteDatabase::insertResolutionFeatures(sqlite3_int64 trackId, const ResolutionFeatures& block) {
+    const TrackFeatures& features = block.features;
+
+    int i = 1;
+    sqlite3_bind_int64(insertResolutionStmt, i++, trackId);
+    sqlite3_bind_int(insertResolutionStmt, i++, block.resolution.windowSize);
+    sqlite3_bind_int(insertResolutionStmt, i++, block.resolution.hopSize);
+    sqlite3_bind_int64(insertResolutionStmt, i++, block.frameCount);
+
+    // Same order as MONO_FEATURES.
+    for (const FeatureStats* s : { &features.pcmRms, &features.peak, &features.spectralRms, &features.spectralCentroid,
+        &features.spectralRolloff85, &features.spectralFlatness, &features.hfRatio }) {
+        for (double value : { s->mean, s->median, s->stddev, s->p05, s->p50, s->p95, s->min, s->max, s->samplingError })
+            sqlite3_bind_double(insertResolutionStmt, i++, value);
+    }
+
+    if (sqlite3_step(insertResolutionStmt) != SQLITE_DONE)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    sqlite3_reset(insertResolutionStmt);
+    sqlite3_clear_bindings(insertResolutionStmt);
+}
+
+
+void SqliteDatabase::insertRejection(const TrackRejection& rejection) {
+    const auto storedPath = BlackMetalSanitizer::toUtf8(rejection.path);
+
+    sqlite3_bind_text(insertRejectionStmt, 1, storedPath.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(insertRejectionStmt, 2, rejectReasonCode(rejection.reason), -1, SQLITE_STATIC);
+
+    if (sqlite3_step(insertRejectionStmt) != SQLITE_DONE)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    sqlite3_reset(insertRejectionStmt);
+    sqlite3_clear_bindings(insertRejectionStmt);
 }
 
 
@@ -164,11 +426,13 @@ void SqliteDatabase::createSchema() {
             duration_seconds REAL NOT NULL,
             sample_rate INTEGER NOT NULL,
             total_samples INTEGER NOT NULL,
-            frame_count INTEGER NOT NULL
+            frame_count INTEGER NOT NULL,
+            analysis_mode TEXT NOT NULL DEFAULT 'full',
+            window_function TEXT NOT NULL DEFAULT 'hann'
         );
     )sql");
 
-    exec(db, R"sql(
+    exec(db, (R"sql(
         CREATE TABLE IF NOT EXISTS track_features (
             track_id INTEGER PRIMARY KEY,
 
@@ -203,7 +467,100 @@ void SqliteDatabase::createSchema() {
             hf_ratio_p05 REAL, hf_ratio_p50 REAL, hf_ratio_p95 REAL,
             hf_ratio_min REAL, hf_ratio_max REAL,
 
+            pcm_rms_sampling_error REAL, peak_sampling_error REAL,
+            spectral_rms_sampling_error REAL, spectral_centroid_sampling_error REAL,
+            spectral_rolloff85_sampling_error REAL, spectral_flatness_sampling_error REAL,
+            hf_ratio_sampling_error REAL,
+
+            inter_channel_correlation_mean REAL, inter_channel_correlation_median REAL,
+            inter_channel_correlation_stddev REAL, inter_channel_correlation_p05 REAL,
+            inter_channel_correlation_p50 REAL, inter_channel_correlation_p95 REAL,
+            inter_channel_correlation_min REAL, inter_channel_correlation_max REAL,
+
+            stereo_width_mean REAL, stereo_width_median REAL, stereo_width_stddev REAL,
+            stereo_width_p05 REAL, stereo_width_p50 REAL, stereo_width_p95 REAL,
+            stereo_width_min REAL, stereo_width_max REAL,
+
+            side_energy_ratio_mean REAL, side_energy_ratio_median REAL,
+            side_energy_ratio_stddev REAL, side_energy_ratio_p05 REAL,
+            side_energy_ratio_p50 REAL, side_energy_ratio_p95 REAL,
+            side_energy_ratio_min REAL, side_energy_ratio_max REAL,
+
+            inter_channel_correlation_sampling_error REAL, stereo_width_sampling_error REAL,
+            side_energy_ratio_sampling_error REAL,
+
+            )sql" + mfccColumns(" REAL") + R"sql(,
+
             FOREIGN KEY(track_id) REFERENCES tracks(id)
         );
+    )sql").c_str());
+
+    // Files the pre-decode probe turned away, with the reason code; cleared once a later run analyzes them.
+    exec(db, R"sql(
+        CREATE TABLE IF NOT EXISTS rejected_tracks (
+            path TEXT PRIMARY KEY,
+            reason TEXT NOT NULL
+        );
     )sql");
+
+    // One row per track and extra STFT resolution (--multi-resolution); the main resolution stays in track_features.
+    exec(db, ("CREATE TABLE IF NOT EXISTS track_resolution_features ("
+        "track_id INTEGER NOT NULL, "
+        "window_size INTEGER NOT NULL, "
+        "hop_size INTEGER NOT NULL, "
+        "frame_count INTEGER NOT NULL, "
+        + resolutionColumns(" REAL") + ", "
+        "PRIMARY KEY (track_id, window_size), "
+        "FOREIGN KEY(track_id) REFERENCES tracks(id));").c_str());
+
+    // Mean chroma and estimated key, one row per track, from the LONG_WINDOW_SIZE tonal pass (an extra resolution of
+    // that size, or --tonal); tracks analyzed with neither have no row.
+    exec(db, ("CREATE TABLE IF NOT EXISTS track_tonality ("
+        "track_id INTEGER PRIMARY KEY, "
+        "key_tonic TEXT, "
+        "key_mode TEXT, "
+        "key_strength REAL, "
+        + chromaColumns(" REAL") + ", "
+        "FOREIGN KEY(track_id) REFERENCES tracks(id));").c_str());
+
+    // Databases created before survey mode.
+    ensureColumn("tracks", "analysis_mode", "TEXT NOT NULL DEFAULT 'full'");
+    // Databases created before --window; every run until then used Hann.
+    ensureColumn("tracks", "window_function", "TEXT NOT NULL DEFAULT 'hann'");
+    for (const char* column : {
+        "pcm_rms_sampling_error", "peak_sampling_error",
+        "spectral_rms_sampling_error", "spectral_centroid_sampling_error",
+        "spectral_rolloff85_sampling_error", "spectral_flatness_sampling_error",
+        "hf_ratio_sampling_error" })
+        ensureColumn("track_features", column, "REAL");
+
+    // Databases created before stereo mode.
+    for (const char* feature : { "inter_channel_correlation", "stereo_width", "side_energy_ratio" }) {
+        for (const char* stat : { "mean", "median", "stddev", "p05", "p50", "p95", "min", "max", "sampling_error" })
+            ensureColumn("track_features", std::string(feature) + "_" + stat, "REAL");
+    }
+
+    // Databases created before MFCCs.
+    for (int k = 1; k <= CONSTANTS::MFCC_COEFFICIENTS; ++k) {
+        for (const char* stat : FEATURE_STATS)
+            ensureColumn("track_features", "mfcc_" + std::to_string(k) + "_" + stat, "REAL");
+    }
+}
+
+void SqliteDatabase::ensureColumn(const std::string& table, const std::string& column, const std::string& declaration) {
+    sqlite3_stmt* stmt = nullptr;
+    const std::string pragma = "PRAGMA table_info(" + table + ");";
+
+    if (sqlite3_prepare_v2(db, pragma.c_str(), -1, &stmt, nullptr) != SQLITE_OK)
+        throw std::runtime_error(sqlite3_errmsg(db));
+
+    bool found = false;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        const auto* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        found = name && column == name;
+    }
+    sqlite3_finalize(stmt);
+
+    if (!found)
+        exec(db, ("ALTER TABLE " + table + " ADD COLUMN " + column + " " + declaration + ";").c_str());
 }
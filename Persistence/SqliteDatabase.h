@@ -12,11 +12,21 @@ public:
     void begin();
     void commit();
     void insertTrack(const Track& track);
+    void insertRejection(const TrackRejection& rejection);
 private:
     void open(const std::string& path);
     void createSchema();
+    void ensureColumn(const std::string& table, const std::string& column, const std::string& declaration);
+    void insertResolutionFeatures(sqlite3_int64 trackId, const ResolutionFeatures& block);
+    void insertTonality(sqlite3_int64 trackId, const TrackFeatures& features);
 
     sqlite3* db = nullptr;
     sqlite3_stmt* insertTrackStmt;
     sqlite3_stmt* insertFeaturesStmt;
+    sqlite3_stmt* insertRejectionStmt;
+    sqlite3_stmt* clearRejectionStmt;
+    sqlite3_stmt* insertResolutionStmt;
+    sqlite3_stmt* clearResolutionsStmt;
+    sqlite3_stmt* insertTonalityStmt;
+    sqlite3_stmt* clearTonalityStmt;
 };
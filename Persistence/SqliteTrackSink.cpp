@@ -10,6 +10,10 @@ void SqliteTrackSink::consume(Track&& track) {
     queue.push(std::move(track));
 }
 
+void SqliteTrackSink::reject(TrackRejection&& rejection) {
+    queue.push(std::move(rejection));
+}
+
 void SqliteTrackSink::close() {
     queue.close();
     if (dbThread.joinable())
@@ -23,11 +27,14 @@ SqliteTrackSink::~SqliteTrackSink() {
 void SqliteTrackSink::dbLoop() {
     constexpr std::size_t BATCH_SIZE = 500;
 
-    Track track;
+    std::variant<Track, TrackRejection> item;
     std::size_t batchCount = 0;
 
-    while (queue.pop(track)) {
-        db.insertTrack(track);
+    while (queue.pop(item)) {
+        if (const Track* track = std::get_if<Track>(&item))
+            db.insertTrack(*track);
+        else
+            db.insertRejection(std::get<TrackRejection>(item));
         ++batchCount;
 
         if (batchCount >= BATCH_SIZE) {
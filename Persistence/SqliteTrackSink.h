@@ -1,4 +1,6 @@
 #pragma once
+#include <variant>
+
 #include "TrackSink.h"
 #include "SqliteDatabase.h"
 #include "../Queue//BlockingQueue.h"
@@ -9,12 +11,14 @@ public:
     ~SqliteTrackSink() override;
 
     void consume(Track&& track) override;
+    void reject(TrackRejection&& rejection) override;
     void close() override;
 
 private:
     void dbLoop();
 
-    BlockingQueue<Track> queue;
+    // One queue, so rows reach the database in the order the workers finished them.
+    BlockingQueue<std::variant<Track, TrackRejection>> queue;
     std::thread dbThread;
     SqliteDatabase db;
 };
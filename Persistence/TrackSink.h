@@ -6,5 +6,6 @@ class TrackSink {
 public:
     virtual ~TrackSink() = default;
     virtual void consume(Track&& track) = 0;
+    virtual void reject(TrackRejection&& rejection) = 0;
     virtual void close() = 0;
 };
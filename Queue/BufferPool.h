@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/*
+ * Byte buffers for the read-ahead stage, bounded by the total bytes handed out rather than by a count.
+ * Released buffers are kept and handed out again, so read-ahead stops allocating once warm. The capacity kept idle
+ * counts against the same budget: whatever would push outstanding plus idle bytes over it is freed, so one huge file
+ * does not stay allocated for the rest of the run.
+ */
+class BufferPool {
+public:
+    explicit BufferPool(std::size_t byteBudget)
+        : byteBudget(byteBudget) {
+    }
+
+    // Blocks until size more bytes fit in the budget. A single file larger than the whole budget
+    // is let through once nothing else is outstanding, so it cannot stall the pipeline.
+    std::vector<std::uint8_t> acquire(std::size_t size) {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        budgetCv.wait(lock, [&] {
+            return outstanding == 0 || outstanding + size <= byteBudget;
+            });
+
+        outstanding += size;
+        return takeIdle(size);
+    }
+
+    // Non-blocking acquire, for a caller that can free budget itself while it waits.
+    bool tryAcquire(std::size_t size, std::vector<std::uint8_t>& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (outstanding != 0 && outstanding + size > byteBudget)
+            return false;
+
+        outstanding += size;
+        out = takeIdle(size);
+        return true;
+    }
+
+    // size must be what was passed to acquire().
+    void release(std::vector<std::uint8_t>&& buffer, std::size_t size) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        outstanding -= size;
+        if (buffer.capacity() > 0 && outstanding + idleBytes + buffer.capacity() <= byteBudget) {
+            buffer.clear();
+            idleBytes += buffer.capacity();
+            idle.push_back(std::move(buffer));
+        }
+        budgetCv.notify_all();
+    }
+
+private:
+    // Called with the lock held, after size was added to outstanding. Hands out the smallest idle buffer that
+    // already fits size (an empty one when none does), then frees the largest idle ones until the budget holds again.
+    // Only size counts as outstanding, so a reused buffer may exceed it by at most MAX_SLACK_DIVISOR-th of size:
+    // larger ones would hold unbudgeted capacity until release.
+    std::vector<std::uint8_t> takeIdle(std::size_t size) {
+        std::vector<std::uint8_t> buffer;
+
+        auto best = idle.end();
+        for (auto it = idle.begin(); it != idle.end(); ++it) {
+            if (it->capacity() >= size && it->capacity() - size <= size / MAX_SLACK_DIVISOR
+                && (best == idle.end() || it->capacity() < best->capacity()))
+                best = it;
+        }
+        if (best != idle.end()) {
+            idleBytes -= best->capacity();
+            buffer = std::move(*best);
+            idle.erase(best);
+        }
+
+        while (!idle.empty() && outstanding + idleBytes > byteBudget) {
+            auto largest = std::max_element(idle.begin(), idle.end(), [](const auto& a, const auto& b) {
+                return a.capacity() < b.capacity();
+                });
+            idleBytes -= largest->capacity();
+            idle.erase(largest);
+        }
+
+        return buffer;
+    }
+
+    static constexpr std::size_t MAX_SLACK_DIVISOR = 4;
+
+    std::mutex mutex;
+    std::condition_variable budgetCv;
+    std::vector<std::vector<std::uint8_t>> idle;
+    std::size_t byteBudget;
+    std::size_t outstanding = 0;
+    std::size_t idleBytes = 0; // sum of the idle buffers' capacities
+};
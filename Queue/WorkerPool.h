@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Helper threads shared by all track workers, for splitting the work of one track across cores.
+ * parallelFor never waits for a helper to become free: the calling thread claims chunks as well, so when
+ * every helper is busy with another track it simply runs all of its own chunks.
+ * Dispatch does not allocate: each call takes one of `callers` job slots made at construction, and the helpers
+ * are handed slots through a ring sized for all of them. A call that finds every slot taken runs alone.
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned threads, unsigned callers = 1)
+        : jobs(callers),
+        pending(static_cast<std::size_t>(threads) * callers) {
+        freeJobs.reserve(callers);
+        for (Job& job : jobs)
+            freeJobs.push_back(&job);
+
+        helpers.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) {
+            helpers.emplace_back([this] {
+                while (Job* job = take()) {
+                    run(*job);
+                    release(*job);
+                }
+                });
+        }
+    }
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        pendingCv.notify_all();
+
+        for (auto& helper : helpers)
+            helper.join();
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Calls fn(i) once for every i in [0, count) and returns when all calls have finished. The first exception
+    // thrown by fn is rethrown here once the other chunks are done.
+    template <typename Fn>
+    void parallelFor(std::size_t count, Fn&& fn) {
+        if (count == 0)
+            return;
+
+        // A call beyond the slots gets a job of its own that no helper ever sees.
+        Job local;
+        Job* slot = acquire();
+        Job& job = slot ? *slot : local;
+
+        job.next.store(0);
+        job.done.store(0);
+        job.count = count;
+        job.fn = const_cast<void*>(static_cast<const void*>(std::addressof(fn)));
+        job.call = [](void* target, std::size_t i) { (*static_cast<std::remove_reference_t<Fn>*>(target))(i); };
+        job.error = nullptr;
+
+        // The caller's reference and one per queued entry; a helper may only get to its entry after the caller has
+        // returned, finds no chunk left and never touches fn.
+        const std::size_t wanted = slot ? std::min<std::size_t>(helpers.size(), count - 1) : 0;
+        job.refs.store(1 + wanted);
+        if (wanted > 0) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (std::size_t h = 0; h < wanted; ++h)
+                    pending[(pendingHead + pendingCount++) % pending.size()] = &job;
+            }
+            pendingCv.notify_all();
+        }
+
+        run(job);
+
+        std::exception_ptr error;
+        {
+            std::unique_lock<std::mutex> lock(job.mutex);
+            job.doneCv.wait(lock, [&] {
+                return job.done.load() == job.count;
+                });
+            error = job.error;
+        }
+
+        if (slot)
+            release(job);
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+    unsigned size() const {
+        return static_cast<unsigned>(helpers.size());
+    }
+
+private:
+    struct Job {
+        std::atomic<std::size_t> next{ 0 };
+        std::atomic<std::size_t> done{ 0 };
+        std::atomic<std::size_t> refs{ 0 };
+        std::size_t count = 0;
+        void* fn = nullptr;
+        void (*call)(void*, std::size_t) = nullptr;
+        std::mutex mutex;
+        std::condition_variable doneCv;
+        std::exception_ptr error;
+    };
+
+    static void run(Job& job) {
+        for (;;) {
+            const std::size_t i = job.next.fetch_add(1);
+            if (i >= job.count)
+                return;
+
+            try {
+                job.call(job.fn, i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                if (!job.error)
+                    job.error = std::current_exception();
+            }
+
+            if (job.done.fetch_add(1) + 1 == job.count) {
+                std::lock_guard<std::mutex> lock(job.mutex);
+                job.doneCv.notify_all();
+            }
+        }
+    }
+
+    Job* acquire() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeJobs.empty())
+            return nullptr;
+
+        Job* job = freeJobs.back();
+        freeJobs.pop_back();
+        return job;
+    }
+
+    // The slot goes back once the caller and every helper handed it are through with it.
+    void release(Job& job) {
+        if (job.refs.fetch_sub(1) != 1)
+            return;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        freeJobs.push_back(&job);
+    }
+
+    Job* take() {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingCv.wait(lock, [&] {
+            return closed || pendingCount > 0;
+            });
+
+        if (pendingCount == 0)
+            return nullptr;
+
+        Job* job = pending[pendingHead];
+        pendingHead = (pendingHead + 1) % pending.size();
+        --pendingCount;
+        return job;
+    }
+
+    std::vector<Job> jobs;
+    std::vector<Job*> freeJobs;
+
+    // At most `helpers` entries per slot in use, so the ring never fills.
+    std::vector<Job*> pending;
+    std::size_t pendingHead = 0;
+    std::size_t pendingCount = 0;
+
+    std::mutex mutex;
+    std::condition_variable pendingCv;
+    bool closed = false;
+
+    std::vector<std::thread> helpers;
+};
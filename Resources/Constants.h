@@ -1,8 +1,48 @@
 ﻿#pragma once
 
+#include <cstddef>
+#include <cstdint>
+
 namespace CONSTANTS {
     constexpr const char* INPUT_DIRECTORY = R"(T:\Music)";
     constexpr const char* DB_PATH_V5 = R"(Q:\\Visual Studio Projects\\Sqlite\\spectral_audit_V0.5.db)";
+    constexpr const char* PCM_CACHE_DIRECTORY = R"(Q:\SpectralAudit\pcm_cache)";
+    constexpr const char* FFTW_WISDOM_PATH = R"(Q:\SpectralAudit\fftw_wisdom)";
     constexpr int WINDOW_SIZE = 2048;
     constexpr int HOP_SIZE = 256;
+    // Frames per batched FFTW call on the whole-track path; --bench-fft sweeps the alternatives.
+    constexpr int STFT_BATCH_FRAMES = 8;
+    // Extra resolutions of --multi-resolution: short windows for transients, long ones for tonal detail.
+    constexpr int SHORT_WINDOW_SIZE = 512;
+    constexpr int SHORT_HOP_SIZE = 128;
+    constexpr int LONG_WINDOW_SIZE = 8192;
+    constexpr int LONG_HOP_SIZE = 2048;
+    // Mel filterbank behind the MFCCs: triangular bands spaced evenly in mel between the two edges (capped at Nyquist).
+    constexpr int MEL_BANDS = 40;
+    constexpr int MFCC_COEFFICIENTS = 13;
+    constexpr double MEL_MIN_HZ = 20.0;
+    constexpr double MEL_MAX_HZ = 16000.0;
+    // Chroma range, analyzed at LONG_WINDOW_SIZE / LONG_HOP_SIZE. PitchClassMap raises the lower edge to where bins are
+    // under a semitone apart: ~91 Hz at 44.1 kHz and ~99 Hz at 48 kHz, so CHROMA_MIN_HZ only applies below ~27 kHz.
+    constexpr int PITCH_CLASSES = 12;
+    constexpr double CHROMA_MIN_HZ = 55.0;
+    constexpr double CHROMA_MAX_HZ = 5000.0;
+    constexpr int DECODE_CHUNK_FRAMES = 8192;
+    constexpr std::size_t READ_AHEAD_BYTES = std::size_t{ 512 } << 20;
+    constexpr unsigned READ_QUEUE_DEPTH = 32;
+    constexpr std::size_t READ_SLOT_BYTES = std::size_t{ 1 } << 20;
+    constexpr int SURVEY_SEGMENTS = 10;
+    constexpr double SURVEY_SEGMENT_SECONDS = 5.0;
+    constexpr std::size_t PARALLEL_DECODE_MIN_BYTES = std::size_t{ 48 } << 20;
+    constexpr unsigned PARALLEL_DECODE_THREADS = 8;
+    constexpr std::size_t PARALLEL_DECODE_MIN_CHUNK_FRAMES = 2000;
+    // Decoded samples a worker keeps capacity for between tracks (10 minutes at 48 kHz); a longer track's buffers are freed.
+    constexpr std::size_t RETAINED_DECODE_SAMPLES = std::size_t{ 48000 } * 60 * 10;
+    // Whole-track STFTs of at least this many frames (~3 minutes at 44.1 kHz) are split into chunks for the frame pool.
+    constexpr std::size_t PARALLEL_STFT_MIN_FRAMES = 32768;
+    constexpr std::size_t PARALLEL_STFT_CHUNK_FRAMES = 4096;
+    constexpr unsigned PARALLEL_STFT_THREADS = 8;
+    // Bytes after the ID3v2 tag searched for frame sync before a file is rejected; the decoder itself would search on.
+    constexpr std::size_t PROBE_SYNC_BYTES = std::size_t{ 1 } << 20;
+    constexpr std::uint64_t PCM_CACHE_BYTES = std::uint64_t{ 256 } << 30;
 }
\ No newline at end of file
@@ -3,64 +3,243 @@
 #include "Utilities/AudioMetadataExtractor.h"
 #include "Resources/Constants.h"
 
+#include "Core/AudioDecoder.h"
 #include "Core/Mp3Decoder.h"
 #include "Core/StftProcessor.h"
 #include "Core/FeatureExtractor.h"
+#include "Core/FrameAssembler.h"
+#include "Core/PcmCache.h"
 #include "Core/TrackAggregator.h"
+#include "Core/TrackContext.h"
+#include "Diagnostics/AllocationCounter.h"
+#include "Queue/BufferPool.h"
+#include "Queue/WorkerPool.h"
+#include "Utilities/DiskOrder.h"
+#include "Utilities/FileLoader.h"
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
 #include <mutex>
+#include <span>
+#include <thread>
+
+// Writes frame `index` of every output; the vectors already hold that many frames.
+static void analyzeFrame(const StftFrame& frame, int windowSize, const FeatureExtractor& extractor, const FrameOutputs& out, std::size_t index) {
+    if (out.features) {
+        // The extractor fills every spectral feature; pcmRms and peak are the time-domain ones of the raw frame.
+        FrameFeatures& f = (*out.features)[index];
+        f = extractor.extract(frame.power);
+        f.pcmRms = std::sqrt(frame.sumSquares / windowSize);
+        f.peak = frame.peak;
+    }
+    if (out.mfcc)
+        extractor.extractMfcc(frame.power, (*out.mfcc)[index]);
+    if (out.chroma)
+        extractor.extractChroma(frame.power, (*out.chroma)[index]);
+}
+
+static void appendFrame(const StftFrame& frame, int windowSize, const FeatureExtractor& extractor, const FrameOutputs& out) {
+    const std::size_t index = out.size();
+    out.resize(index + 1);
+    analyzeFrame(frame, windowSize, extractor, out, index);
+}
+
+static void appendFrame(const Sample* frame, StftProcessor& stft, const FeatureExtractor& extractor, const FrameOutputs& out) {
+    appendFrame(stft.computeFrame(frame), stft.getWindowSize(), extractor, out);
+}
+
+// The mono features come from mid, which is exactly the mono downmix. With L = M + S and R = M - S
+// the L/R correlation follows from the mid and side sums alone.
+static void analyzeStereoFrame(const Sample* mid, const Sample* side, TrackContext& context, const FeatureExtractor& extractor) {
+    const int windowSize = context.stft.getWindowSize();
+    const StftFrame& midFrame = context.stft.computeFrame(mid);
+
+    appendFrame(midFrame, windowSize, extractor, context.outputs());
+    FrameFeatures& f = context.frameFeatures.back();
+    extractor.extractStereo(midFrame.power, context.sideStft.computeFrame(side).power, f);
+
+    double mm = 0.0, ss = 0.0, ms = 0.0;
+    for (int i = 0; i < windowSize; ++i) {
+        const double m = mid[i];
+        const double s = side[i];
+        mm += m * m;
+        ss += s * s;
+        ms += m * s;
+    }
+
+    // 0 for silent frames.
+    const double energy = mm + ss;
+    const double norm = std::sqrt(std::max(0.0, (energy + 2.0 * ms) * (energy - 2.0 * ms)));
+    f.interChannelCorrelation = (mm - ss) / (norm + 1e-12);
+}
+
+// The calling thread's processor for one resolution, made on first use; parallel STFT chunks run on any thread.
+static StftProcessor& threadStft(const StftProcessor& like) {
+    thread_local std::vector<std::unique_ptr<StftProcessor>> processors;
+
+    for (auto& p : processors) {
+        if (p->getWindowSize() == like.getWindowSize() && p->getHopSize() == like.getHopSize()
+            && p->getBatchFrames() == like.getBatchFrames() && p->getWindowFunction() == like.getWindowFunction())
+            return *p;
+    }
+    processors.push_back(std::make_unique<StftProcessor>(like.getWindowSize(), like.getHopSize(), like.getBatchFrames(), like.getWindowFunction()));
+    return *processors.back();
+}
+
+// Frames [first, last) of samples, written to out[first, last).
+static void analyzeFrameRange(const std::vector<Sample>& samples, const StftProcessor& like, std::size_t first, std::size_t last,
+    const FeatureExtractor& extractor, const FrameOutputs& out) {
+    const int windowSize = like.getWindowSize();
+    const std::size_t hopSize = static_cast<std::size_t>(like.getHopSize());
+    StftProcessor& stft = threadStft(like);
+
+    const std::size_t count = (last - first - 1) * hopSize + static_cast<std::size_t>(windowSize);
+    stft.forEachFrame(samples.data() + first * hopSize, count, [&](const StftFrame& frame) {
+        analyzeFrame(frame, windowSize, extractor, out, first + frame.index);
+        });
+}
+
+// Frames the extra resolutions and the tonal pass complete with this chunk of mono (or mid) samples.
+static void analyzeResolutions(TrackContext& context, const FeatureExtractor& extractor, const Sample* samples, std::size_t count) {
+    for (auto& r : context.resolutions) {
+        ResolutionContext& resolution = *r;
+        const FrameOutputs out = resolution.outputs();
+        resolution.assembler.push(samples, count, [&](const Sample* frame) {
+            appendFrame(frame, resolution.stft, extractor, out);
+            });
+    }
+}
+
+// One feature block per extra resolution that completed a frame. Survey runs aggregate by segment.
+static void addResolutionFeatures(TrackContext& context, bool survey, double sampledFraction, Track& track) {
+    for (auto& r : context.resolutions) {
+        if (!r->stored || r->frameFeatures.empty())
+            continue;
+
+        ResolutionFeatures block;
+        block.resolution = r->resolution;
+        block.frameCount = r->frameFeatures.size();
+        block.features = survey
+            ? TrackAggregator::aggregate(r->frameFeatures, r->segmentEnds, sampledFraction, context.aggregationScratch)
+            : TrackAggregator::aggregate(r->frameFeatures, context.aggregationScratch);
+        track.addResolutionFeatures(std::move(block));
+    }
+}
+
+// Reserves for a track of totalFrames samples, like the main resolution does.
+static void reserveResolutions(TrackContext& context, std::uint64_t totalFrames) {
+    for (auto& r : context.resolutions) {
+        const std::uint64_t windowSize = static_cast<std::uint64_t>(r->resolution.windowSize);
+        if (totalFrames >= windowSize)
+            r->outputs().reserve(static_cast<std::size_t>(1 + (totalFrames - windowSize) / r->resolution.hopSize));
+    }
+}
+
+// Decodes up to maxFrames into the context's chunk and analyzes every frame it completes.
+// Returns the number of PCM frames read, 0 at the end of the stream.
+static std::size_t analyzeNextChunk(TrackContext& context, const FeatureExtractor& extractor, std::size_t maxFrames, bool stereo) {
+    std::vector<Sample>& chunk = context.chunk;
+    maxFrames = std::min(maxFrames, chunk.size());
+
+    if (!stereo) {
+        const std::size_t read = context.decoder->readMono(chunk.data(), maxFrames);
+        const FrameOutputs out = context.outputs();
+        context.assembler.push(chunk.data(), read, [&](const Sample* frame) {
+            appendFrame(frame, context.stft, extractor, out);
+            });
+        analyzeResolutions(context, extractor, chunk.data(), read);
+        return read;
+    }
+
+    std::vector<Sample>& sideChunk = context.sideChunk;
+    sideChunk.resize(chunk.size());
+
+    const std::size_t read = context.decoder->readMidSide(chunk.data(), sideChunk.data(), maxFrames);
+    context.assembler.pushPair(chunk.data(), sideChunk.data(), read, [&](const Sample* mid, const Sample* side) {
+        analyzeStereoFrame(mid, side, context, extractor);
+        });
+    analyzeResolutions(context, extractor, chunk.data(), read);
+    return read;
+}
 
 TrackBatchProcessor::TrackBatchProcessor(std::filesystem::path inputDirectory,
-    TrackSink& sink)
+    TrackSink& sink, ProcessingOptions options)
     : inputDirectory(std::move(inputDirectory)),
-    sink(sink) {
+    sink(sink),
+    options(options) {
+    if (!this->options.pcmCacheDirectory.empty())
+        pcmCache = std::make_unique<PcmCache>(this->options.pcmCacheDirectory, this->options.pcmCacheBytes);
 }
 
-void TrackBatchProcessor::runParallel(std::size_t workerCount, std::size_t queueCapacity) {
+TrackBatchProcessor::~TrackBatchProcessor() = default;
+
+void TrackBatchProcessor::runParallel(std::size_t workerCount, std::size_t readAheadBytes) {
     Logger logger;
 
     if (workerCount == 0) 
         workerCount = 1;
 
-    if (queueCapacity == 0) 
-        queueCapacity = 1;
+    if (readAheadBytes == 0) 
+        readAheadBytes = 1;
 
-    BlockingQueue<std::filesystem::path> workQueue(queueCapacity);
+    const unsigned frameThreads = std::min(options.frameThreads, std::max(std::thread::hardware_concurrency(), 1u));
+    if (frameThreads > 0)
+        framePool = std::make_unique<WorkerPool>(frameThreads, static_cast<unsigned>(workerCount));
+
+    // Backpressure comes from the byte budget, not from the number of queued tracks.
+    BufferPool readAhead(readAheadBytes);
+    BlockingQueue<PrefetchedFile> workQueue(std::numeric_limits<std::size_t>::max());
 
     std::atomic<std::size_t> failedCount{ 0 };
+    std::atomic<std::size_t> rejectedCount{ 0 };
     std::atomic<std::size_t> enqueuedCount{ 0 };
+    std::atomic<std::size_t> allocatingCount{ 0 };
+    std::atomic<std::uint64_t> allocationCount{ 0 };
 
     std::vector<std::thread> workers;
     workers.reserve(workerCount);
 
     for (std::size_t i = 0; i < workerCount; ++i) {
         workers.emplace_back([&] {
-            workerLoop(workQueue, failedCount, logger);
+            workerLoop(workQueue, readAhead, failedCount, rejectedCount, allocatingCount, allocationCount, logger);
             });
     }
 
     std::thread producer([&] {
-        producerLoop(workQueue, enqueuedCount, logger);
+        producerLoop(workQueue, readAhead, enqueuedCount, logger);
         });
 
     producer.join();
     for (auto& w : workers)
         w.join();
+    framePool.reset();
+
+    logger.logSummary(enqueuedCount.load() - failedCount.load() - rejectedCount.load(), failedCount.load(), rejectedCount.load(), enqueuedCount.load());
 
-    logger.logSummary(enqueuedCount.load() - failedCount.load(), failedCount.load(), enqueuedCount.load());
+    if (AllocationCounter::enabled())
+        logger.logAllocations(allocatingCount.load(), allocationCount.load());
 }
 
 
-void TrackBatchProcessor::workerLoop(BlockingQueue<std::filesystem::path>& workQueue, std::atomic<std::size_t>& failedCount, Logger& logger) {
-    namespace fs = std::filesystem;
-    fs::path path;
+void TrackBatchProcessor::workerLoop(BlockingQueue<PrefetchedFile>& workQueue, BufferPool& readAhead, std::atomic<std::size_t>& failedCount,
+    std::atomic<std::size_t>& rejectedCount, std::atomic<std::size_t>& allocatingCount, std::atomic<std::uint64_t>& allocationCount, Logger& logger) {
+    PrefetchedFile item;
+
+    TrackContext context(CONSTANTS::WINDOW_SIZE, CONSTANTS::HOP_SIZE, options.stftBatchFrames, options.extraResolutions, options.window, options.tonalPass);
+    bool warm = false;
 
-    while (workQueue.pop(path)) {
+    while (workQueue.pop(item)) {
+        const std::filesystem::path& path = item.path;
+
+        if (!item.bytes.empty())
+            context.file.adopt(std::move(item.bytes));
 
         std::optional<Track> track;
         logger.logGroupChange(path.parent_path().parent_path());
 
         try {
-            track = processTrack(path);
+            track = processTrack(path, context);
         }
         catch (const std::exception& e) {
             logger.logException(path, e);
@@ -69,6 +248,25 @@ void TrackBatchProcessor::workerLoop(BlockingQueue<std::filesystem::path>& workQ
             logger.logException(path, L"Unknown exception");
         }
 
+        // The first track sizes the buffers; after that the DSP path should not allocate.
+        if (warm && context.dspAllocations > 0) {
+            allocatingCount.fetch_add(1, std::memory_order_relaxed);
+            allocationCount.fetch_add(context.dspAllocations, std::memory_order_relaxed);
+        }
+        warm = true;
+        const RejectReason rejectReason = context.rejectReason;
+        context.reset();
+
+        if (item.reservedBytes > 0)
+            readAhead.release(context.file.release(), item.reservedBytes);
+
+        if (rejectReason != RejectReason::None) {
+            logger.logRejected(path, rejectReason);
+            sink.reject({ path, rejectReason });
+            rejectedCount.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+
         if (!track) {
             failedCount.fetch_add(1, std::memory_order_relaxed);
             continue;
@@ -78,8 +276,9 @@ void TrackBatchProcessor::workerLoop(BlockingQueue<std::filesystem::path>& workQ
     }
 }
 
-void TrackBatchProcessor::producerLoop(BlockingQueue<std::filesystem::path>& workQueue, std::atomic<std::size_t>& enqueuedCount, Logger& logger) {
+void TrackBatchProcessor::producerLoop(BlockingQueue<PrefetchedFile>& workQueue, BufferPool& readAhead, std::atomic<std::size_t>& enqueuedCount, Logger& logger) {
     namespace fs = std::filesystem;
+    std::vector<fs::path> paths;
 
     try {
         for (const auto& entry : fs::recursive_directory_iterator(inputDirectory)) {
@@ -88,85 +287,337 @@ void TrackBatchProcessor::producerLoop(BlockingQueue<std::filesystem::path>& wor
                 continue;
 
             const auto& path = entry.path();
-            const auto ext = path.extension();
 
-            if (ext != ".mp3" && ext != ".MP3")
+            if (!AudioDecoder::isSupportedExtension(path))
                 continue;
 
-            if (!workQueue.push(path))
-                break;
-
-            enqueuedCount.fetch_add(1, std::memory_order_relaxed);
+            paths.push_back(path);
         }
     }
     catch (const std::exception& e) {
         logger.logFilesystemError(e);
     }
+
+    // One thread reads everything in on-disk order while the workers only ever see bytes in memory.
+    DiskOrder::sort(paths);
+
+    auto loader = FileLoader::create(options.readBackend, options.readQueueDepth);
+    bool accepting = true;
+
+    const FileLoader::OnLoaded enqueue = [&](PrefetchedFile&& item) {
+        // Leave the track to the worker's own path-based access.
+        if (item.bytes.empty() && item.reservedBytes > 0) {
+            readAhead.release(std::move(item.bytes), item.reservedBytes);
+            item.bytes = {};
+            item.reservedBytes = 0;
+        }
+
+        if (!workQueue.push(std::move(item))) {
+            accepting = false;
+            return;
+        }
+        enqueuedCount.fetch_add(1, std::memory_order_relaxed);
+    };
+
+    for (auto& path : paths) {
+        if (!accepting)
+            break;
+
+        PrefetchedFile item;
+        item.path = std::move(path);
+
+        std::error_code ec;
+        const auto size = fs::file_size(item.path, ec);
+
+        if (ec || size == 0) {
+            enqueue(std::move(item));
+            continue;
+        }
+
+        item.reservedBytes = static_cast<std::size_t>(size);
+
+        // Budget held by reads still in flight only comes back once they complete, so reap them
+        // rather than block on the pool.
+        while (!readAhead.tryAcquire(item.reservedBytes, item.bytes)) {
+            if (!loader->waitOne(enqueue)) {
+                item.bytes = readAhead.acquire(item.reservedBytes);
+                break;
+            }
+        }
+
+        item.bytes.resize(item.reservedBytes);
+        loader->submit(std::move(item), enqueue);
+    }
+
+    loader->finish(enqueue);
     workQueue.close();
 }
 
-std::optional<Track> TrackBatchProcessor::processTrack(const std::filesystem::path& path) {
-    auto decoded = Mp3Decoder::decode(path,CONSTANTS::WINDOW_SIZE);
+std::optional<Track> TrackBatchProcessor::processTrack(const std::filesystem::path& path, TrackContext& context) {
+    // Read once, normally ahead of time by the producer; decoder and tag reader both work from this buffer.
+    FileBuffer& file = context.file;
+    if (!file.isOpen())
+        file.open(path);
+
+    // The decoders' own fallbacks (mapping, the temp copy) cannot read what FileBuffer could not either, so from
+    // here on everything works from the buffer.
+    if (!file.isOpen()) {
+        std::error_code ec;
+        const bool empty = std::filesystem::file_size(path, ec) == 0 && !ec;
+        context.rejectReason = empty ? RejectReason::Empty : RejectReason::Unreadable;
+        return std::nullopt;
+    }
+
+    const AudioDecoder::Format format = AudioDecoder::detect(file.data(), file.size(), path);
+    context.selectDecoder(format);
+
+    // WAV and FLAC headers are parsed at open, which is as cheap as a probe.
+    const bool isMp3 = format != AudioDecoder::Format::Wav && format != AudioDecoder::Format::Flac;
+    if (isMp3) {
+        context.rejectReason = Mp3Decoder::probe(file.data(), file.size(), CONSTANTS::WINDOW_SIZE);
+        if (context.rejectReason != RejectReason::None)
+            return std::nullopt;
+    }
+
+    if (options.survey)
+        return processTrackSurvey(path, context);
+
+    // The PCM cache holds whole mono tracks, so cached MP3s take the whole-track path. So do long MP3s when
+    // parallelDecode asks for them to be split across the frame pool.
+    const bool cached = pcmCache && isMp3;
+    const bool parallel = options.parallelDecode && framePool && isMp3
+        && file.size() >= CONSTANTS::PARALLEL_DECODE_MIN_BYTES;
+    WorkerPool* decodePool = parallel ? framePool.get() : nullptr;
+
+    // Stereo analysis needs the channels, which only the streaming decoders keep; WAV and FLAC only stream.
+    if ((options.streamingDecode && !cached && !parallel) || options.stereo || format == AudioDecoder::Format::Wav || format == AudioDecoder::Format::Flac)
+        return processTrackStreaming(path, context);
 
-    if (!decoded)
+    const std::uint64_t allocationsBefore = AllocationCounter::threadCount();
+    DecodedAudio& decoded = context.decoded;
+
+    const bool ok = cached
+        ? Mp3Decoder::decode(file.data(), file.size(), path, decoded, *pcmCache, decodePool)
+        : Mp3Decoder::decode(file.data(), file.size(), path, decoded, decodePool);
+
+    if (!ok)
         return std::nullopt;
 
+    // The probe only bounds the length of untagged streams; the decode is what tells.
+    if (decoded.samples.size() < CONSTANTS::WINDOW_SIZE) {
+        context.rejectReason = RejectReason::TooShort;
+        return std::nullopt;
+    }
+
     std::size_t frameCount = 0;
-    TrackFeatures features = extractTrackFeatures(decoded->samples, decoded->sampleRate, frameCount);
-    Track track = buildTrack(path,features,decoded->sampleRate,decoded->samples.size(),frameCount);
+    TrackFeatures features = extractTrackFeatures(context, decoded.sampleRate, frameCount);
+    context.dspAllocations = AllocationCounter::threadCount() - allocationsBefore;
+
+    Track track = buildTrack(path,file,features,decoded.sampleRate,decoded.samples.size(),frameCount);
+    addResolutionFeatures(context, false, 1.0, track);
     return track;
 }
 
-TrackFeatures TrackBatchProcessor::extractTrackFeatures(const std::vector<double>& samples, int sampleRate, std::size_t& outFrameCount) {
+std::optional<Track> TrackBatchProcessor::processTrackStreaming(const std::filesystem::path& path, TrackContext& context) {
     const int windowSize = CONSTANTS::WINDOW_SIZE;
     const int hopSize = CONSTANTS::HOP_SIZE;
 
-    if (samples.size() < windowSize) {
-        outFrameCount = 0;
-        return TrackFeatures{};
+    const FileBuffer& file = context.file;
+    AudioDecoder& decoder = *context.decoder;
+    const bool opened = decoder.open(file.data(), file.size());
+
+    if (!opened) {
+        std::cerr << "Decode failed: " << path << '\n';
+        return std::nullopt;
     }
 
-    static thread_local StftProcessor stft(windowSize, hopSize);
-    auto magnitudes = stft.computeMagnitudes(samples);
+    const int sampleRate = decoder.getSampleRate();
+    const std::uint64_t allocationsBefore = AllocationCounter::threadCount();
 
-    FeatureExtractor extractor(sampleRate);
+    const FeatureExtractor extractor(sampleRate);
+    context.assembler.reset();
+    for (auto& r : context.resolutions)
+        r->assembler.reset();
 
-    std::vector<FrameFeatures> frameFeatures;
-    frameFeatures.reserve(magnitudes.size());
+    std::vector<FrameFeatures>& frameFeatures = context.frameFeatures;
+    std::size_t totalSamples = 0;
 
-    for (std::size_t frameIdx = 0; frameIdx < magnitudes.size(); ++frameIdx) {
-        const std::size_t offset = frameIdx * hopSize;
-        if (offset + windowSize > samples.size())
-            break;
+    const std::uint64_t expectedFrames = decoder.getTotalFrames();
+    if (expectedFrames >= static_cast<std::uint64_t>(windowSize))
+        context.outputs().reserve(static_cast<std::size_t>(1 + (expectedFrames - windowSize) / hopSize));
+    reserveResolutions(context, expectedFrames);
+
+    while (const std::size_t read = analyzeNextChunk(context, extractor, context.chunk.size(), options.stereo))
+        totalSamples += read;
+
+    if (decoder.failed()) {
+        std::cerr << "Decode failed: " << path << '\n';
+        return std::nullopt;
+    }
+    decoder.close();
+
+    if (totalSamples < static_cast<std::size_t>(windowSize)) {
+        context.rejectReason = RejectReason::TooShort;
+        return std::nullopt;
+    }
+
+    TrackFeatures features = TrackAggregator::aggregate(frameFeatures, context.aggregationScratch);
+    if (options.stereo)
+        TrackAggregator::aggregateStereo(frameFeatures, context.segmentEnds, 1.0, context.aggregationScratch, features);
+    TrackAggregator::aggregateMfcc(context.frameMfcc, context.segmentEnds, 1.0, context.aggregationScratch, features);
+    if (context.tonal)
+        TrackAggregator::aggregateTonality(context.tonal->frameChroma, features);
+
+    context.dspAllocations = AllocationCounter::threadCount() - allocationsBefore;
+
+    Track track = buildTrack(path, file, features, sampleRate, totalSamples, frameFeatures.size());
+    addResolutionFeatures(context, false, 1.0, track);
+    return track;
+}
+
+std::optional<Track> TrackBatchProcessor::processTrackSurvey(const std::filesystem::path& path, TrackContext& context) {
+    const int windowSize = CONSTANTS::WINDOW_SIZE;
+    const int hopSize = CONSTANTS::HOP_SIZE;
 
-        double sumSq = 0.0;
-        double peak = 0.0;
+    const FileBuffer& file = context.file;
+    AudioDecoder& decoder = *context.decoder;
+    const bool opened = decoder.open(file.data(), file.size());
 
-        for (int i = 0; i < windowSize; ++i) {
-            const double s = samples[offset + i];
-            sumSq += s * s;
-            peak = std::max(peak, std::abs(s));
+    if (!opened) {
+        std::cerr << "Decode failed: " << path << '\n';
+        return std::nullopt;
+    }
+
+    const int sampleRate = decoder.getSampleRate();
+    const std::uint64_t totalFrames = decoder.getTotalFrames();
+    const std::size_t segments = static_cast<std::size_t>(std::max(options.surveySegments, 1));
+    const std::uint64_t segmentFrames = std::max<std::uint64_t>(
+        static_cast<std::uint64_t>(options.surveySegmentSeconds * sampleRate), windowSize);
+
+    // Nothing to gain when the segments would cover most of the track anyway.
+    if (totalFrames < 2 * segments * segmentFrames) {
+        decoder.close();
+        return processTrackStreaming(path, context);
+    }
+
+    const std::uint64_t allocationsBefore = AllocationCounter::threadCount();
+
+    const FeatureExtractor extractor(sampleRate);
+    FrameAssembler& assembler = context.assembler;
+
+    std::vector<FrameFeatures>& frameFeatures = context.frameFeatures;
+    std::vector<std::size_t>& segmentEnds = context.segmentEnds;
+    context.outputs().reserve(segments * static_cast<std::size_t>(segmentFrames / hopSize + 1));
+    segmentEnds.reserve(segments);
+    reserveResolutions(context, segments * segmentFrames);
+    for (auto& r : context.resolutions)
+        r->segmentEnds.reserve(segments);
+    std::uint64_t sampledFrames = 0;
+
+    for (std::size_t s = 0; s < segments; ++s) {
+        // Centre of the s-th of `segments` equal strata.
+        const std::uint64_t centre = (2 * s + 1) * totalFrames / (2 * segments);
+        const std::uint64_t start = centre - segmentFrames / 2;
+
+        if (!decoder.seek(start)) {
+            std::cerr << "Decode failed: " << path << '\n';
+            return std::nullopt;
+        }
+
+        assembler.reset();
+        for (auto& r : context.resolutions)
+            r->assembler.reset();
+        std::uint64_t remaining = segmentFrames;
+
+        while (remaining > 0) {
+            const std::size_t want = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, context.chunk.size()));
+            const std::size_t read = analyzeNextChunk(context, extractor, want, options.stereo);
+            if (read == 0)
+                break;
+
+            remaining -= read;
+            sampledFrames += read;
+        }
+
+        if (decoder.failed()) {
+            std::cerr << "Decode failed: " << path << '\n';
+            return std::nullopt;
         }
+        segmentEnds.push_back(frameFeatures.size());
+        for (auto& r : context.resolutions)
+            r->segmentEnds.push_back(r->frameFeatures.size());
+    }
+    decoder.close();
+
+    const double sampledFraction = static_cast<double>(sampledFrames) / static_cast<double>(totalFrames);
+    TrackFeatures features = TrackAggregator::aggregate(frameFeatures, segmentEnds, sampledFraction, context.aggregationScratch);
+    if (options.stereo)
+        TrackAggregator::aggregateStereo(frameFeatures, segmentEnds, sampledFraction, context.aggregationScratch, features);
+    TrackAggregator::aggregateMfcc(context.frameMfcc, segmentEnds, sampledFraction, context.aggregationScratch, features);
+    if (context.tonal)
+        TrackAggregator::aggregateTonality(context.tonal->frameChroma, features);
+    context.dspAllocations = AllocationCounter::threadCount() - allocationsBefore;
+
+    Track track = buildTrack(path, file, features, sampleRate, static_cast<std::size_t>(totalFrames), frameFeatures.size(), AnalysisMode::Survey);
+    addResolutionFeatures(context, true, sampledFraction, track);
+    return track;
+}
 
-        FrameFeatures f{};
-        f.pcmRms = std::sqrt(sumSq / windowSize);
-        f.peak = peak;
+TrackFeatures TrackBatchProcessor::extractTrackFeatures(TrackContext& context, int sampleRate, std::size_t& outFrameCount) {
+    const std::vector<Sample>& samples = context.decoded.samples;
 
-        const FrameFeatures spectral = extractor.extract(magnitudes[frameIdx]);
-        f.spectralRms = spectral.spectralRms;
-        f.spectralCentroid = spectral.spectralCentroid;
-        f.spectralRolloff85 = spectral.spectralRolloff85;
-        f.spectralFlatness = spectral.spectralFlatness;
-        f.hfRatio = spectral.hfRatio;
+    if (samples.size() < CONSTANTS::WINDOW_SIZE) {
+        outFrameCount = 0;
+        return TrackFeatures{};
+    }
+
+    const FeatureExtractor extractor(sampleRate);
+    analyzeAllFrames(samples, context.stft, extractor, context.outputs());
 
-        frameFeatures.push_back(f);
+    // The extra resolutions and the tonal pass read the same samples; only the FFT and their own features are repeated.
+    for (auto& r : context.resolutions)
+        analyzeAllFrames(samples, r->stft, extractor, r->outputs());
+
+    outFrameCount = context.frameFeatures.size();
+    TrackFeatures features = TrackAggregator::aggregate(context.frameFeatures, context.aggregationScratch);
+    TrackAggregator::aggregateMfcc(context.frameMfcc, context.segmentEnds, 1.0, context.aggregationScratch, features);
+    if (context.tonal)
+        TrackAggregator::aggregateTonality(context.tonal->frameChroma, features);
+    return features;
+}
+
+// Only the features of each frame are kept; its spectrum is consumed while still in cache. Long tracks are split
+// into chunks of whole FFT batches that run on the frame pool, each writing its own slice of out, so the frames are
+// grouped into batches exactly as the serial loop groups them and the result is the same.
+void TrackBatchProcessor::analyzeAllFrames(const std::vector<Sample>& samples, StftProcessor& stft, const FeatureExtractor& extractor, const FrameOutputs& out) {
+    const std::size_t windowSize = static_cast<std::size_t>(stft.getWindowSize());
+    const std::size_t hopSize = static_cast<std::size_t>(stft.getHopSize());
+
+    out.resize(0);
+    if (samples.size() < windowSize)
+        return;
+
+    const std::size_t frameCount = 1 + (samples.size() - windowSize) / hopSize;
+
+    if (!framePool || frameCount < CONSTANTS::PARALLEL_STFT_MIN_FRAMES) {
+        out.reserve(frameCount);
+        stft.forEachFrame(samples.data(), samples.size(), [&](const StftFrame& frame) {
+            appendFrame(frame, stft.getWindowSize(), extractor, out);
+            });
+        return;
     }
 
-    outFrameCount = frameFeatures.size();
-    return TrackAggregator::aggregate(frameFeatures);
+    const std::size_t batch = static_cast<std::size_t>(stft.getBatchFrames());
+    const std::size_t chunkFrames = (CONSTANTS::PARALLEL_STFT_CHUNK_FRAMES + batch - 1) / batch * batch;
+    const std::size_t chunks = (frameCount + chunkFrames - 1) / chunkFrames;
+
+    out.resize(frameCount);
+    framePool->parallelFor(chunks, [&](std::size_t c) {
+        analyzeFrameRange(samples, stft, c * chunkFrames, std::min(frameCount, (c + 1) * chunkFrames), extractor, out);
+        });
 }
 
-Track TrackBatchProcessor::buildTrack(const std::filesystem::path& path, const TrackFeatures& features, int sampleRate, std::size_t totalSamples, std::size_t frameCount) {
+Track TrackBatchProcessor::buildTrack(const std::filesystem::path& path, const FileBuffer& file, const TrackFeatures& features, int sampleRate, std::size_t totalSamples, std::size_t frameCount, AnalysisMode analysisMode) {
     TrackMetadata metadata{};
     metadata.path = path;
     metadata.sampleRate = sampleRate;
@@ -176,8 +627,12 @@ Track TrackBatchProcessor::buildTrack(const std::filesystem::path& path, const T
         : 0.0;
 
     metadata.frameCount = frameCount;
+    metadata.analysisMode = analysisMode;
+    metadata.window = options.window;
+
+    auto tags = AudioMetadataReader::extract(file.data(), file.size());
 
-    if (auto tags = AudioMetadataReader::extract(path)) {
+    if (tags) {
         metadata.artist = tags->artist;
         metadata.title = tags->title;
         metadata.album = tags->album;
@@ -1,28 +1,101 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <vector>
 
+#include "Core/SampleType.h"
+#include "Core/WindowFunction.h"
+#include "Resources/Constants.h"
 #include "Model/Track.h"
 #include "Queue/BlockingQueue.h"
 #include "Utilities/Logger.h"
 #include "Persistence/TrackSink.h"
+#include "Utilities/FileBuffer.h"
+#include "Utilities/FileLoader.h"
+
+struct TrackContext;
+struct FrameOutputs;
+class BufferPool;
+class PcmCache;
+class StftProcessor;
+class FeatureExtractor;
+class WorkerPool;
+
+struct ProcessingOptions {
+    // Decode and analyze in fixed-size chunks instead of holding the whole track and its spectrogram in memory.
+    bool streamingDecode = true;
+
+    // MP3s of at least PARALLEL_DECODE_MIN_BYTES take the whole-track path, decoded in chunks on the frame pool,
+    // even when streamingDecode is set. Needs frameThreads > 0; the decoded track is held in memory whole.
+    bool parallelDecode = false;
+
+    // Analyze only surveySegments evenly spaced windows of surveySegmentSeconds each. Rows are stored with
+    // analysis_mode = 'survey' and carry sampling-error estimates; a later full run overwrites them.
+    bool survey = false;
+    int surveySegments = CONSTANTS::SURVEY_SEGMENTS;
+    double surveySegmentSeconds = CONSTANTS::SURVEY_SEGMENT_SECONDS;
+
+    // Also run the side channel through the STFT and store inter-channel correlation, stereo width and
+    // side-energy ratio. Mono features are unchanged: they come from the mid channel, which is the mono downmix.
+    bool stereo = false;
+
+    // Consecutive frames the whole-track path windows into one buffer and transforms with a single FFTW call.
+    // 1 transforms frame by frame. Streaming frames arrive one at a time and are never batched.
+    int stftBatchFrames = CONSTANTS::STFT_BATCH_FRAMES;
+
+    // Analysis window of every STFT resolution. Features are only comparable between runs with the same window.
+    WindowFunction window = WindowFunction::Hann;
+
+    // STFT resolutions analyzed besides WINDOW_SIZE / HOP_SIZE, from the same decoded samples: only the FFT and
+    // feature work is repeated. Each is stored as its own feature block, mono features only. A LONG_WINDOW_SIZE /
+    // LONG_HOP_SIZE one also gives the chroma and key, with no pass of its own.
+    std::vector<StftResolution> extraResolutions;
+
+    // Without such a resolution, the chroma and key come from a LONG_WINDOW_SIZE / LONG_HOP_SIZE STFT run only for
+    // them. That transforms every track once more: about two thirds of the main resolution's STFT time on top of it, a
+    // third of the per-track DSP time (see --bench-features). Off, tracks get no track_tonality row.
+    bool tonalPass = false;
+
+    // Helper threads shared by all workers for the STFT of long whole-track decodes, capped at the core count.
+    // 0 keeps every track on its worker's thread.
+    unsigned frameThreads = CONSTANTS::PARALLEL_STFT_THREADS;
+
+    // How the producer reads files ahead of the workers. io_uring falls back to blocking reads off Linux.
+    FileLoader::Backend readBackend = FileLoader::Backend::IoUring;
+    unsigned readQueueDepth = CONSTANTS::READ_QUEUE_DEPTH;
+
+    // When set, decoded mono PCM of MP3s is kept here, keyed by file content, so re-analysis runs skip decoding.
+    // MP3s then take the whole-track path; stereo and survey runs neither read nor fill the cache.
+    std::filesystem::path pcmCacheDirectory;
+    std::uint64_t pcmCacheBytes = CONSTANTS::PCM_CACHE_BYTES;
+};
 
 class TrackBatchProcessor {
 public:
-    explicit TrackBatchProcessor(std::filesystem::path inputDirectory, TrackSink& sink);
-    void runParallel(std::size_t workerCount, std::size_t queueCapacity);
+    explicit TrackBatchProcessor(std::filesystem::path inputDirectory, TrackSink& sink, ProcessingOptions options = {});
+    ~TrackBatchProcessor();
+    // readAheadBytes bounds the file contents held in memory between the I/O stage and the workers.
+    void runParallel(std::size_t workerCount, std::size_t readAheadBytes);
 
 private:
-    void workerLoop(BlockingQueue<std::filesystem::path>& workQueue, std::atomic<std::size_t>& failedCount, Logger& logger);
-    void producerLoop(BlockingQueue<std::filesystem::path>& workQueue, std::atomic<std::size_t>& enqueuedCount, Logger& logger);
+    void workerLoop(BlockingQueue<PrefetchedFile>& workQueue, BufferPool& readAhead, std::atomic<std::size_t>& failedCount,
+        std::atomic<std::size_t>& rejectedCount, std::atomic<std::size_t>& allocatingCount, std::atomic<std::uint64_t>& allocationCount, Logger& logger);
+    void producerLoop(BlockingQueue<PrefetchedFile>& workQueue, BufferPool& readAhead, std::atomic<std::size_t>& enqueuedCount, Logger& logger);
 
-    TrackFeatures extractTrackFeatures(const std::vector<double>& samples,int sampleRate,std::size_t& outFrameCount);
-    Track buildTrack(const std::filesystem::path& path, const TrackFeatures& features, int sampleRate, std::size_t totalSamples, std::size_t frameCount);
-    std::optional<Track>processTrack(const std::filesystem::path& path);
+    TrackFeatures extractTrackFeatures(TrackContext& context, int sampleRate, std::size_t& outFrameCount);
+    void analyzeAllFrames(const std::vector<Sample>& samples, StftProcessor& stft, const FeatureExtractor& extractor, const FrameOutputs& out);
+    Track buildTrack(const std::filesystem::path& path, const FileBuffer& file, const TrackFeatures& features, int sampleRate, std::size_t totalSamples, std::size_t frameCount, AnalysisMode analysisMode = AnalysisMode::Full);
+    std::optional<Track>processTrack(const std::filesystem::path& path, TrackContext& context);
+    std::optional<Track>processTrackStreaming(const std::filesystem::path& path, TrackContext& context);
+    std::optional<Track>processTrackSurvey(const std::filesystem::path& path, TrackContext& context);
 
 private:
     std::filesystem::path inputDirectory;
 	TrackSink& sink;
+    ProcessingOptions options;
+    std::unique_ptr<PcmCache> pcmCache;
+    std::unique_ptr<WorkerPool> framePool; // runParallel only
 };
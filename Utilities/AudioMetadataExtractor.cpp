@@ -1,23 +1,114 @@
 #include "AudioMetadataExtractor.h"
 
-#include <taglib/fileref.h>
+#include <algorithm>
+#include <cstring>
+
+#include <taglib/flacfile.h>
+#include <taglib/id3v2framefactory.h>
+#include <taglib/mpegfile.h>
 #include <taglib/tag.h>
+#include <taglib/taglib.h>
+#include <taglib/tbytevector.h>
+#include <taglib/tiostream.h>
+#include <taglib/wavfile.h>
 
-std::optional<AudioTags> AudioMetadataReader::extract(const std::filesystem::path& path) {
-    TagLib::FileRef file(path.c_str());
+// IOStream's offset and length types changed with TagLib 2.
+#if TAGLIB_MAJOR_VERSION >= 2
+using StreamOffset = TagLib::offset_t;
+using StreamStart = TagLib::offset_t; // insert() and removeBlock()
+using StreamLength = std::size_t;
+#else
+using StreamOffset = long;
+using StreamStart = unsigned long;
+using StreamLength = unsigned long;
+#endif
 
-    if (file.isNull() || !file.tag()) {
-        return std::nullopt;
+// Read-only TagLib stream over bytes owned by someone else. ByteVectorStream would copy the whole file first;
+// this only copies the blocks TagLib asks for, which are the tags.
+class MemoryStream : public TagLib::IOStream {
+public:
+    MemoryStream(const std::uint8_t* data, std::size_t size)
+        : data(reinterpret_cast<const char*>(data)),
+        size(static_cast<StreamOffset>(size)) {
+    }
+
+    TagLib::FileName name() const override { return ""; }
+
+    TagLib::ByteVector readBlock(StreamLength length) override {
+        const StreamOffset count = std::min<StreamOffset>(static_cast<StreamOffset>(length), size - position);
+        if (count <= 0)
+            return TagLib::ByteVector();
+
+        TagLib::ByteVector block(data + position, static_cast<unsigned int>(count));
+        position += count;
+        return block;
     }
 
-    TagLib::Tag* tag = file.tag();
+    void writeBlock(const TagLib::ByteVector&) override {}
+    void insert(const TagLib::ByteVector&, StreamStart, StreamLength) override {}
+    void removeBlock(StreamStart, StreamLength) override {}
+    void truncate(StreamOffset) override {}
+
+    bool readOnly() const override { return true; }
+    bool isOpen() const override { return true; }
+
+    void seek(StreamOffset offset, Position p = Beginning) override {
+        const StreamOffset base = p == Beginning ? 0 : p == Current ? position : size;
+        position = std::clamp<StreamOffset>(base + offset, 0, size);
+    }
+
+    StreamOffset tell() const override { return position; }
+    StreamOffset length() override { return size; }
+
+private:
+    const char* data;
+    StreamOffset size;
+    StreamOffset position = 0;
+};
+
+static AudioTags toAudioTags(const TagLib::Tag& tag) {
     AudioTags out;
 
-    out.artist = tag->artist().to8Bit(true);
-    out.title = tag->title().to8Bit(true);
-    out.album = tag->album().to8Bit(true);
-    out.year = tag->year();
+    out.artist = tag.artist().to8Bit(true);
+    out.title = tag.title().to8Bit(true);
+    out.album = tag.album().to8Bit(true);
+    out.year = tag.year();
 
     return out;
 }
 
+template <typename File>
+static std::optional<AudioTags> extractFrom(File& file) {
+    if (!file.isValid() || !file.tag()) {
+        return std::nullopt;
+    }
+
+    return toAudioTags(*file.tag());
+}
+
+// Reads tags from bytes the decoder already has in memory, so the file is neither opened nor copied a second time.
+// The container is recognized by its magic bytes; anything else is treated as MPEG.
+std::optional<AudioTags> AudioMetadataReader::extract(const std::uint8_t* data, std::size_t size) {
+    MemoryStream stream(data, size);
+
+    if (size >= 4 && std::memcmp(data, "fLaC", 4) == 0) {
+#if TAGLIB_MAJOR_VERSION >= 2
+        TagLib::FLAC::File file(&stream, false);
+#else
+        TagLib::FLAC::File file(&stream, TagLib::ID3v2::FrameFactory::instance(), false);
+#endif
+        return extractFrom(file);
+    }
+
+    if (size >= 12 && std::memcmp(data, "RIFF", 4) == 0 && std::memcmp(data + 8, "WAVE", 4) == 0) {
+        TagLib::RIFF::WAV::File file(&stream, false);
+        return extractFrom(file);
+    }
+
+#if TAGLIB_MAJOR_VERSION >= 2
+    TagLib::MPEG::File file(&stream, false);
+#else
+    TagLib::MPEG::File file(&stream, TagLib::ID3v2::FrameFactory::instance(), false);
+#endif
+    return extractFrom(file);
+}
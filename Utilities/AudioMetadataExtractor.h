@@ -1,6 +1,7 @@
 #pragma once
 
-#include <filesystem>
+#include <cstddef>
+#include <cstdint>
 #include <optional>
 #include <string>
 
@@ -13,5 +14,5 @@ struct AudioTags {
 
 class AudioMetadataReader {
 public:
-    static std::optional<AudioTags>extract(const std::filesystem::path& path);
+    static std::optional<AudioTags>extract(const std::uint8_t* data, std::size_t size);
 };
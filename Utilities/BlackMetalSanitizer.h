@@ -11,10 +11,5 @@ class BlackMetalSanitizer {
 public:
     static void setupConsole();
 
-    static std::filesystem::path makeSafeTempCopy(const std::filesystem::path& originalPath);
-    static void cleanup(const std::filesystem::path& tempPath);
     static std::string toUtf8(const std::filesystem::path& p);
-
-private:
-    static std::string sanitizeFilename(const std::filesystem::path& path);
 };
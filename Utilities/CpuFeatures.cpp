@@ -0,0 +1,45 @@
+#include "CpuFeatures.h"
+
+#if defined(SPECTRAL_AUDIT_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+static CpuFeatures detect() {
+    CpuFeatures features;
+
+#if defined(SPECTRAL_AUDIT_X86) && defined(_MSC_VER) && !defined(__clang__)
+    int regs[4]{};
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+
+    __cpuid(regs, 1);
+    features.sse2 = (regs[3] & (1 << 26)) != 0;
+
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7)
+        return features;
+
+    // The OS has to save the wider registers on context switch, not just the CPU support them.
+    const unsigned long long xcr0 = _xgetbv(0);
+    const bool ymmState = (xcr0 & 0x6) == 0x6;
+    const bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+    __cpuidex(regs, 7, 0);
+    features.avx2 = ymmState && (regs[1] & (1 << 5)) != 0;
+    features.avx512 = zmmState && (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0;
+#elif defined(SPECTRAL_AUDIT_X86)
+    __builtin_cpu_init();
+    features.sse2 = __builtin_cpu_supports("sse2");
+    features.avx2 = __builtin_cpu_supports("avx2");
+    features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+
+    return features;
+}
+
+const CpuFeatures& CpuFeatures::get() {
+    static const CpuFeatures features = detect();
+    return features;
+}
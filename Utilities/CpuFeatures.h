@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+ * x86 SIMD support detected once at startup, used to pick kernels at runtime.
+ * SIMD_TARGET lets GCC/Clang compile a single function for a wider ISA than the build baseline;
+ * MSVC allows intrinsics of any ISA without it.
+ */
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SPECTRAL_AUDIT_X86 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIMD_TARGET(isa)
+#else
+#define SIMD_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool avx512 = false; // F + BW
+
+    static const CpuFeatures& get();
+};
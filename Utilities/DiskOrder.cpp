@@ -0,0 +1,114 @@
+#include "DiskOrder.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <winioctl.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+#endif
+
+namespace {
+    struct Location {
+        std::optional<std::uint64_t> physical;
+        std::optional<std::uint64_t> fileId;
+    };
+}
+
+#ifdef _WIN32
+
+static Location locate(const std::filesystem::path& path) {
+    Location location;
+
+    HANDLE file = CreateFileW(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, 0, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return location;
+
+    // Only the first extent is needed; ERROR_MORE_DATA just means the file has others.
+    STARTING_VCN_INPUT_BUFFER in{};
+    RETRIEVAL_POINTERS_BUFFER out{};
+    DWORD returned = 0;
+    const BOOL ok = DeviceIoControl(file, FSCTL_GET_RETRIEVAL_POINTERS, &in, sizeof(in), &out, sizeof(out), &returned, nullptr);
+    if ((ok || GetLastError() == ERROR_MORE_DATA) && out.ExtentCount > 0)
+        location.physical = static_cast<std::uint64_t>(out.Extents[0].Lcn.QuadPart);
+
+    BY_HANDLE_FILE_INFORMATION info{};
+    if (GetFileInformationByHandle(file, &info))
+        location.fileId = (static_cast<std::uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+
+    CloseHandle(file);
+    return location;
+}
+
+#else
+
+static Location locate(const std::filesystem::path& path) {
+    Location location;
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return location;
+
+#ifdef __linux__
+    // fiemap ends in a flexible array; room for one extent is all that is needed.
+    alignas(fiemap) unsigned char request[sizeof(fiemap) + sizeof(fiemap_extent)]{};
+    auto* map = reinterpret_cast<fiemap*>(request);
+    map->fm_length = FIEMAP_MAX_OFFSET;
+    map->fm_extent_count = 1;
+
+    if (ioctl(fd, FS_IOC_FIEMAP, map) == 0 && map->fm_mapped_extents > 0)
+        location.physical = map->fm_extents[0].fe_physical;
+#endif
+
+    struct stat st {};
+    if (fstat(fd, &st) == 0)
+        location.fileId = static_cast<std::uint64_t>(st.st_ino);
+
+    ::close(fd);
+    return location;
+}
+
+#endif
+
+void DiskOrder::sort(std::vector<std::filesystem::path>& paths) {
+    std::vector<Location> locations;
+    locations.reserve(paths.size());
+    for (const auto& path : paths)
+        locations.push_back(locate(path));
+
+    // Keys are only comparable if every file has one of the same kind.
+    const bool physical = std::all_of(locations.begin(), locations.end(), [](const Location& l) { return l.physical.has_value(); });
+    const bool fileId = std::all_of(locations.begin(), locations.end(), [](const Location& l) { return l.fileId.has_value(); });
+
+    if (!physical && !fileId)
+        return;
+
+    std::vector<std::size_t> order(paths.size());
+    std::iota(order.begin(), order.end(), std::size_t{ 0 });
+
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return physical
+            ? *locations[a].physical < *locations[b].physical
+            : *locations[a].fileId < *locations[b].fileId;
+        });
+
+    std::vector<std::filesystem::path> sorted;
+    sorted.reserve(paths.size());
+    for (std::size_t i : order)
+        sorted.push_back(std::move(paths[i]));
+
+    paths = std::move(sorted);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <filesystem>
+#include <vector>
+
+/*
+ * Sorts files by where their data starts on disk, so a single reader sweeps an HDD instead of seeking
+ * between directories. Uses the first physical extent (FIEMAP on Linux, retrieval pointers on Windows),
+ * then the inode / file index, and keeps directory order when neither is known for every file.
+ */
+class DiskOrder {
+public:
+    static void sort(std::vector<std::filesystem::path>& paths);
+};
@@ -0,0 +1,62 @@
+#include "FileBuffer.h"
+
+#include <fstream>
+
+bool FileBuffer::open(const std::filesystem::path& path) {
+    close();
+
+    if (mapped.open(path))
+        return true;
+
+    return readAll(path, bytes);
+}
+
+void FileBuffer::adopt(std::vector<std::uint8_t>&& buffer) {
+    close();
+    bytes = std::move(buffer);
+}
+
+std::vector<std::uint8_t> FileBuffer::release() {
+    mapped.close();
+
+    std::vector<std::uint8_t> out;
+    out.swap(bytes);
+    return out;
+}
+
+bool FileBuffer::readAll(const std::filesystem::path& path, std::vector<std::uint8_t>& out) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+        return false;
+
+    const std::streamsize length = in.tellg();
+    if (length <= 0)
+        return false;
+
+    out.resize(static_cast<std::size_t>(length));
+    in.seekg(0);
+
+    if (!in.read(reinterpret_cast<char*>(out.data()), length)) {
+        out.clear();
+        return false;
+    }
+
+    return true;
+}
+
+void FileBuffer::close() {
+    mapped.close();
+    bytes.clear();
+}
+
+bool FileBuffer::isOpen() const {
+    return mapped.isOpen() || !bytes.empty();
+}
+
+const std::uint8_t* FileBuffer::data() const {
+    return mapped.isOpen() ? mapped.data() : bytes.data();
+}
+
+std::size_t FileBuffer::size() const {
+    return mapped.isOpen() ? mapped.size() : bytes.size();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "MappedFile.h"
+
+/*
+ * The bytes of one track, mapped or read exactly once, shared by the decoder and the tag reader.
+ */
+class FileBuffer {
+public:
+    FileBuffer() = default;
+
+    FileBuffer(const FileBuffer&) = delete;
+    FileBuffer& operator=(const FileBuffer&) = delete;
+
+    // Maps the file, falling back to a single sequential read when mapping is not possible.
+    bool open(const std::filesystem::path& path);
+    // Takes over bytes that were already read ahead of time; release() hands the storage back once done.
+    void adopt(std::vector<std::uint8_t>&& buffer);
+    std::vector<std::uint8_t> release();
+    void close();
+
+    static bool readAll(const std::filesystem::path& path, std::vector<std::uint8_t>& out);
+
+    bool isOpen() const;
+    const std::uint8_t* data() const;
+    std::size_t size() const;
+
+private:
+    MappedFile mapped;
+    std::vector<std::uint8_t> bytes;
+};
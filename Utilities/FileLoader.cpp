@@ -0,0 +1,74 @@
+#include "FileLoader.h"
+
+#include "FileBuffer.h"
+#include "IoUringFileLoader.h"
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+std::unique_ptr<FileLoader> FileLoader::create(Backend backend, unsigned queueDepth) {
+#ifdef SPECTRAL_AUDIT_IO_URING
+    if (backend == Backend::IoUring) {
+        auto loader = std::make_unique<IoUringFileLoader>(queueDepth);
+        if (loader->isReady())
+            return loader;
+    }
+#else
+    (void)backend;
+    (void)queueDepth;
+#endif
+    return std::make_unique<BlockingFileLoader>();
+}
+
+const wchar_t* FileLoader::backendName(Backend backend) {
+    return backend == Backend::IoUring ? L"io_uring" : L"Blocking";
+}
+
+void BlockingFileLoader::submit(PrefetchedFile&& file, const OnLoaded& onLoaded) {
+    if (!read(file.path, file.bytes))
+        file.bytes.clear();
+
+    onLoaded(std::move(file));
+}
+
+bool BlockingFileLoader::waitOne(const OnLoaded&) {
+    return false;
+}
+
+#ifdef _WIN32
+
+bool BlockingFileLoader::read(const std::filesystem::path& path, std::vector<std::uint8_t>& bytes) {
+    return FileBuffer::readAll(path, bytes);
+}
+
+#else
+
+// bytes arrives sized to the length seen when the file was queued; a file that shrank since is trimmed.
+bool BlockingFileLoader::read(const std::filesystem::path& path, std::vector<std::uint8_t>& bytes) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    std::size_t done = 0;
+    while (done < bytes.size()) {
+        const ssize_t n = ::pread(fd, bytes.data() + done, bytes.size() - done, static_cast<off_t>(done));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0) {
+            ::close(fd);
+            return false;
+        }
+        if (n == 0)
+            break;
+        done += static_cast<std::size_t>(n);
+    }
+
+    ::close(fd);
+    bytes.resize(done);
+    return done > 0;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// A track read by the I/O stage. bytes is empty when the read failed; the worker then opens the path itself.
+struct PrefetchedFile {
+    std::filesystem::path path;
+    std::vector<std::uint8_t> bytes;
+    std::size_t reservedBytes = 0; // charged against the read-ahead budget until the worker is done
+};
+
+/*
+ * Reads whole files for the read-ahead stage. submit() hands over a file whose bytes are already sized
+ * to its length; the backend may keep several reads in flight and hands each file back through onLoaded,
+ * on the submitting thread, once it is complete. A failed read comes back with bytes cleared.
+ */
+class FileLoader {
+public:
+    enum class Backend { Blocking, IoUring };
+    using OnLoaded = std::function<void(PrefetchedFile&&)>;
+
+    virtual ~FileLoader() = default;
+
+    virtual void submit(PrefetchedFile&& file, const OnLoaded& onLoaded) = 0;
+    // Waits until at least one in-flight file completes. Returns false if nothing was in flight.
+    virtual bool waitOne(const OnLoaded& onLoaded) = 0;
+
+    void finish(const OnLoaded& onLoaded) {
+        while (waitOne(onLoaded)) {}
+    }
+
+    // Falls back to Blocking when io_uring is not compiled in or the kernel refuses it.
+    static std::unique_ptr<FileLoader> create(Backend backend, unsigned queueDepth);
+    static const wchar_t* backendName(Backend backend);
+};
+
+// One pread per file, on the submitting thread.
+class BlockingFileLoader : public FileLoader {
+public:
+    void submit(PrefetchedFile&& file, const OnLoaded& onLoaded) override;
+    bool waitOne(const OnLoaded& onLoaded) override;
+
+    static bool read(const std::filesystem::path& path, std::vector<std::uint8_t>& bytes);
+};
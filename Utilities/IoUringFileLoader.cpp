@@ -0,0 +1,317 @@
+#include "IoUringFileLoader.h"
+
+#ifdef SPECTRAL_AUDIT_IO_URING
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "../Resources/Constants.h"
+
+struct IoUringFileLoader::Ring {
+    int fd = -1;
+
+    void* sqMap = MAP_FAILED;
+    std::size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    std::size_t cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    bool open(unsigned entries) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0)
+            return false;
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+        const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+            sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+
+        sqMap = mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED)
+            return false;
+
+        if (singleMap) {
+            cqMap = sqMap;
+        }
+        else {
+            cqMap = mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cqMap == MAP_FAILED)
+                return false;
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+            return false;
+
+        auto* sq = static_cast<std::uint8_t*>(sqMap);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        auto* cq = static_cast<std::uint8_t*>(cqMap);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~Ring() {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap)
+            munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED)
+            munmap(sqMap, sqMapSize);
+        if (fd >= 0)
+            ::close(fd);
+    }
+};
+
+IoUringFileLoader::IoUringFileLoader(unsigned queueDepth)
+    : ring(std::make_unique<Ring>()),
+    queueDepth(std::max(queueDepth, 1u)) {
+    if (!ring->open(this->queueDepth)) {
+        ring.reset();
+        return;
+    }
+
+    staging.resize(static_cast<std::size_t>(this->queueDepth) * CONSTANTS::READ_SLOT_BYTES);
+    slots.resize(this->queueDepth);
+    files.resize(this->queueDepth);
+
+    std::vector<iovec> buffers(this->queueDepth);
+    for (unsigned i = 0; i < this->queueDepth; ++i) {
+        buffers[i].iov_base = staging.data() + static_cast<std::size_t>(i) * CONSTANTS::READ_SLOT_BYTES;
+        buffers[i].iov_len = CONSTANTS::READ_SLOT_BYTES;
+    }
+
+    registered = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, buffers.data(), this->queueDepth) == 0;
+}
+
+IoUringFileLoader::~IoUringFileLoader() {
+    // Nothing may still be writing into the staging slots once they are freed.
+    if (ring) {
+        while (std::any_of(slots.begin(), slots.end(), [](const Slot& s) { return s.busy; })) {
+            if (!enter(1))
+                break;
+            reap(nullptr);
+        }
+    }
+
+    for (auto& f : files) {
+        if (f.fd >= 0)
+            ::close(f.fd);
+    }
+}
+
+bool IoUringFileLoader::isReady() const {
+    return ring != nullptr;
+}
+
+bool IoUringFileLoader::usesRegisteredBuffers() const {
+    return registered;
+}
+
+void IoUringFileLoader::submit(PrefetchedFile&& file, const OnLoaded& onLoaded) {
+    while (activeFiles == files.size())
+        waitOne(onLoaded);
+
+    const int fd = ::open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || file.bytes.empty()) {
+        if (fd >= 0)
+            ::close(fd);
+        file.bytes.clear();
+        onLoaded(std::move(file));
+        return;
+    }
+
+    // The ring already keeps READ_SLOT_BYTES chunks from the front of the file onward in flight, so kernel readahead
+    // would only duplicate them. POSIX_FADV_RANDOM turns it off; SEQUENTIAL would double it instead.
+    posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+
+    auto freeEntry = std::find_if(files.begin(), files.end(), [](const InFlightFile& f) { return !f.active; });
+    InFlightFile& entry = *freeEntry;
+
+    entry.file = std::move(file);
+    entry.fd = fd;
+    entry.sequence = nextSequence++;
+    entry.end = entry.file.bytes.size();
+    entry.issued = 0;
+    entry.pending = 0;
+    entry.failed = false;
+    entry.active = true;
+    ++activeFiles;
+
+    fillSlots();
+    enter(0);
+    reap(onLoaded);
+}
+
+bool IoUringFileLoader::waitOne(const OnLoaded& onLoaded) {
+    if (activeFiles == 0)
+        return false;
+
+    std::size_t finished = 0;
+    while (finished == 0 && activeFiles > 0) {
+        if (!enter(1))
+            return false;
+        finished = reap(onLoaded);
+    }
+    return true;
+}
+
+void IoUringFileLoader::fillSlots() {
+    for (std::size_t s = 0; s < slots.size(); ++s) {
+        if (slots[s].busy)
+            continue;
+
+        // Oldest file first keeps the reads close to on-disk order.
+        std::size_t best = files.size();
+        for (std::size_t f = 0; f < files.size(); ++f) {
+            const InFlightFile& candidate = files[f];
+            if (!candidate.active || candidate.failed || candidate.issued >= candidate.end)
+                continue;
+            if (best == files.size() || candidate.sequence < files[best].sequence)
+                best = f;
+        }
+
+        if (best == files.size())
+            return;
+
+        InFlightFile& file = files[best];
+        const std::size_t length = std::min(CONSTANTS::READ_SLOT_BYTES, file.end - file.issued);
+        issue(s, best, file.issued, length);
+        file.issued += length;
+    }
+}
+
+void IoUringFileLoader::issue(std::size_t slot, std::size_t file, std::size_t offset, std::size_t length) {
+    const unsigned tail = *ring->sqTail;
+    const unsigned index = tail & *ring->sqMask;
+
+    io_uring_sqe& sqe = ring->sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe.fd = files[file].fd;
+    sqe.addr = reinterpret_cast<std::uint64_t>(staging.data() + slot * CONSTANTS::READ_SLOT_BYTES);
+    sqe.len = static_cast<std::uint32_t>(length);
+    sqe.off = offset;
+    sqe.buf_index = static_cast<std::uint16_t>(slot);
+    sqe.user_data = slot;
+
+    ring->sqArray[index] = index;
+    __atomic_store_n(ring->sqTail, tail + 1, __ATOMIC_RELEASE);
+    ++unsubmitted;
+
+    slots[slot] = Slot{ file, offset, length, true };
+    ++files[file].pending;
+}
+
+bool IoUringFileLoader::enter(unsigned minComplete) {
+    if (minComplete == 0 && unsubmitted == 0)
+        return true;
+
+    for (;;) {
+        const unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        const long submitted = syscall(__NR_io_uring_enter, ring->fd, unsubmitted, minComplete, flags, nullptr, 0);
+
+        if (submitted >= 0) {
+            unsubmitted -= static_cast<unsigned>(submitted);
+            return true;
+        }
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            return false;
+    }
+}
+
+std::size_t IoUringFileLoader::reap(const OnLoaded& onLoaded) {
+    std::size_t finished = 0;
+
+    unsigned head = *ring->cqHead;
+    const unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head) {
+        const io_uring_cqe& cqe = ring->cqes[head & *ring->cqMask];
+        const std::size_t s = static_cast<std::size_t>(cqe.user_data);
+        const int result = cqe.res;
+
+        Slot& slot = slots[s];
+        InFlightFile& file = files[slot.file];
+        slot.busy = false;
+        --file.pending;
+
+        if (result == -EINTR || result == -EAGAIN) {
+            issue(s, slot.file, slot.offset, slot.length);
+            continue;
+        }
+
+        if (result < 0) {
+            file.failed = true;
+        }
+        else if (result == 0) {
+            // Shorter than when it was queued.
+            file.end = std::min(file.end, slot.offset);
+        }
+        else {
+            const std::size_t read = static_cast<std::size_t>(result);
+            std::memcpy(file.file.bytes.data() + slot.offset, staging.data() + s * CONSTANTS::READ_SLOT_BYTES, read);
+
+            if (read < slot.length)
+                issue(s, slot.file, slot.offset + read, slot.length - read);
+        }
+
+        if (file.pending == 0 && (file.failed || file.issued >= file.end) && onLoaded) {
+            complete(slot.file, onLoaded);
+            ++finished;
+        }
+    }
+
+    __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+
+    if (onLoaded) {
+        fillSlots();
+        enter(0);
+    }
+    return finished;
+}
+
+void IoUringFileLoader::complete(std::size_t index, const OnLoaded& onLoaded) {
+    InFlightFile& file = files[index];
+
+    ::close(file.fd);
+    file.fd = -1;
+    file.active = false;
+    --activeFiles;
+
+    if (file.failed || file.end == 0)
+        file.file.bytes.clear();
+    else
+        file.file.bytes.resize(file.end);
+
+    onLoaded(std::move(file.file));
+}
+
+#endif
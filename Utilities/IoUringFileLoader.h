@@ -0,0 +1,78 @@
+#pragma once
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SPECTRAL_AUDIT_IO_URING 1
+#endif
+#endif
+
+#ifdef SPECTRAL_AUDIT_IO_URING
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "FileLoader.h"
+
+/*
+ * Linux read-ahead backend on the raw io_uring syscalls (no liburing).
+ * queueDepth staging slots of READ_SLOT_BYTES are registered with the kernel once and read into with READ_FIXED.
+ * Chunks of the next queueDepth files are kept in flight together, oldest file first, so a single thread keeps
+ * the disk queue full; each completed chunk is copied into its file's pool buffer.
+ * If the kernel refuses to register the slots (RLIMIT_MEMLOCK) plain READ into the same slots is used instead.
+ */
+class IoUringFileLoader : public FileLoader {
+public:
+    explicit IoUringFileLoader(unsigned queueDepth);
+    ~IoUringFileLoader() override;
+
+    IoUringFileLoader(const IoUringFileLoader&) = delete;
+    IoUringFileLoader& operator=(const IoUringFileLoader&) = delete;
+
+    bool isReady() const;
+    bool usesRegisteredBuffers() const;
+
+    void submit(PrefetchedFile&& file, const OnLoaded& onLoaded) override;
+    bool waitOne(const OnLoaded& onLoaded) override;
+
+private:
+    struct Ring;
+
+    struct InFlightFile {
+        PrefetchedFile file;
+        int fd = -1;
+        std::uint64_t sequence = 0;
+        std::size_t end = 0;    // bytes expected; lowered if the file turns out shorter
+        std::size_t issued = 0; // bytes handed to the kernel so far
+        unsigned pending = 0;   // slots currently reading for this file
+        bool active = false;
+        bool failed = false;
+    };
+
+    struct Slot {
+        std::size_t file = 0;
+        std::size_t offset = 0;
+        std::size_t length = 0;
+        bool busy = false;
+    };
+
+    void fillSlots();
+    void issue(std::size_t slot, std::size_t file, std::size_t offset, std::size_t length);
+    bool enter(unsigned minComplete);
+    std::size_t reap(const OnLoaded& onLoaded);
+    void complete(std::size_t file, const OnLoaded& onLoaded);
+
+    std::unique_ptr<Ring> ring;
+    unsigned queueDepth;
+    bool registered = false;
+
+    std::vector<std::uint8_t> staging;
+    std::vector<Slot> slots;
+    std::vector<InFlightFile> files;
+    std::size_t activeFiles = 0;
+    std::uint64_t nextSequence = 0;
+    unsigned unsubmitted = 0;
+};
+
+#endif
@@ -30,7 +30,18 @@ void Logger::logFilesystemError(const std::exception& e) {
     out << L"Filesystem error: " << e.what() << L'\n';
 }
 
-void Logger::logSummary(std::size_t processed, std::size_t failed, std::size_t enqueued) {
+void Logger::logRejected(const std::filesystem::path& file, RejectReason reason) {
+    std::lock_guard<std::mutex> lk(ioMutex);
+    out << L"Rejected " << file.wstring() << L": " << rejectReasonCode(reason) << L'\n';
+}
+
+void Logger::logSummary(std::size_t processed, std::size_t failed, std::size_t rejected, std::size_t enqueued) {
+	std::lock_guard<std::mutex> lk(ioMutex);
+    out << L"Processed: " << processed << L", Failed: " << failed << L", Rejected: " << rejected << L", Enqueued: " << enqueued << L'\n';
+}
+
+void Logger::logAllocations(std::size_t allocatingTracks, std::uint64_t allocations) {
 	std::lock_guard<std::mutex> lk(ioMutex);
-    out << L"Processed: " << processed << L", Failed: " << failed << L", Enqueued: " << enqueued << L'\n';
+    out << L"Steady-state DSP allocations: " << allocations << L" in " << allocatingTracks
+        << L" tracks (track worker threads only, frame pool helpers not counted)\n";
 }
\ No newline at end of file
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <mutex>
 #include <iostream>
 
+#include "../Model/TrackData.h"
+
 class Logger {
 public:
     explicit Logger(std::wostream& out = std::wcout);
@@ -12,7 +15,9 @@ public:
     void logException(const std::filesystem::path& file, const wchar_t* msg);
     void logException(const std::filesystem::path& file, const std::exception& e);
     void logFilesystemError(const std::exception& e);
-    void logSummary(std::size_t processed, std::size_t failed, std::size_t enqueued);
+    void logRejected(const std::filesystem::path& file, RejectReason reason);
+    void logSummary(std::size_t processed, std::size_t failed, std::size_t rejected, std::size_t enqueued);
+    void logAllocations(std::size_t allocatingTracks, std::uint64_t allocations);
 
 private:
     std::wostream& out;
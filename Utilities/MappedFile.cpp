@@ -0,0 +1,101 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize{};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    // The view keeps the mapping alive, so both handles can go right away.
+    view = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (!view)
+        return false;
+
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close() {
+    if (view)
+        UnmapViewOfFile(view);
+    view = nullptr;
+    length = 0;
+}
+
+#else
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED)
+        return false;
+
+    madvise(mapped, static_cast<std::size_t>(st.st_size), MADV_SEQUENTIAL);
+
+    view = static_cast<const std::uint8_t*>(mapped);
+    length = static_cast<std::size_t>(st.st_size);
+    return true;
+}
+
+void MappedFile::close() {
+    if (view)
+        munmap(const_cast<std::uint8_t*>(view), length);
+    view = nullptr;
+    length = 0;
+}
+
+#endif
+
+bool MappedFile::isOpen() const {
+    return view != nullptr;
+}
+
+const std::uint8_t* MappedFile::data() const {
+    return view;
+}
+
+std::size_t MappedFile::size() const {
+    return length;
+}
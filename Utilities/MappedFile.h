@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/*
+ * Read-only memory mapping of a file, opened through the native wide (Windows) or UTF-8 (POSIX) path,
+ * so no ASCII-safe temp copy is needed to hand the bytes to a decoder.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    bool isOpen() const;
+    const std::uint8_t* data() const;
+    std::size_t size() const;
+
+private:
+    const std::uint8_t* view = nullptr;
+    std::size_t length = 0;
+};
@@ -14,7 +14,7 @@
 static constexpr double EPS = 1e-12;
 bool isDebugEnabled = false;
 
-bool SpectrogramPngWriter::write(const std::string& path, const std::vector<std::vector<double>>& magnitudes, const Options& options) {
+bool SpectrogramPngWriter::write(const std::string& path, const SpectrogramMatrix& magnitudes, const Options& options) {
     if (!isDebugEnabled) {
         return false;
     }
@@ -23,8 +23,8 @@ bool SpectrogramPngWriter::write(const std::string& path, const std::vector<std:
         return false;
     }
 
-    const int frames = static_cast<int>(magnitudes.size());
-    const int bins = static_cast<int>(magnitudes[0].size());
+    const int frames = static_cast<int>(magnitudes.frames());
+    const int bins = static_cast<int>(magnitudes.bins());
 
     const int width = frames;
     const int height = bins;
@@ -40,8 +40,9 @@ bool SpectrogramPngWriter::write(const std::string& path, const std::vector<std:
             srcBin = std::min(srcBin, bins - 1);
         }
 
+        const SpectrogramMatrix::Column column = magnitudes.column(srcBin);
         for (int x = 0; x < width; ++x) {
-            const double mag = magnitudes[x][srcBin];
+            const double mag = column[x];
             const double db = 20.0 * std::log10(mag + EPS);
 
             double v = (db - options.dbFloor) /
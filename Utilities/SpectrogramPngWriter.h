@@ -1,7 +1,8 @@
 #pragma once
 
 #include <string>
-#include <vector>
+
+#include "../Core/SpectrogramMatrix.h"
 
 class SpectrogramPngWriter {
 public:
@@ -11,5 +12,5 @@ public:
         bool logFrequency = true;
     };
 
-    static bool write(const std::string& path, const std::vector<std::vector<double>>& magnitudes, const Options& options = {});
+    static bool write(const std::string& path, const SpectrogramMatrix& magnitudes, const Options& options = {});
 };